@@ -0,0 +1,57 @@
+// Compares the getline/istringstream loader against the mmap loader.
+//
+// Usage: tpch_bench_loader <table_path> [threads] [repetitions]
+#include "query5.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include "bench_util.hpp"
+
+using bench::file_mb;
+using bench::time_load;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <table_path> [threads] [repetitions]" << std::endl;
+        return 1;
+    }
+    std::string table_path = argv[1];
+    int num_threads = argc > 2 ? std::stoi(argv[2]) : 1;
+    int reps = argc > 3 ? std::stoi(argv[3]) : 3;
+
+    CustomerSOA customer;
+    OrdersSOA orders;
+    LineItemSOA lineitem;
+    SupplierSOA supplier;
+    NationSOA nation;
+    RegionSOA region;
+    const std::pair<const char*, const tables*> inputs[] = {
+        {"customer", &customer}, {"orders", &orders}, {"lineitem", &lineitem},
+        {"supplier", &supplier}, {"nation", &nation}, {"region", &region},
+    };
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::left << std::setw(10) << "table" << std::right
+              << std::setw(12) << "rows" << std::setw(12) << "stream ms" << std::setw(12) << "mmap ms"
+              << std::setw(12) << "stream MB/s" << std::setw(12) << "mmap MB/s" << std::setw(10) << "speedup"
+              << std::endl;
+
+    for (const auto& in : inputs) {
+        std::string path = table_path + "\\" + in.first + ".tbl";
+        double mb = file_mb(path);
+        int stream_rows = 0, mmap_rows = 0;
+        double stream_ms = time_load(path, *in.second, num_threads, LoadMode::Stream, reps, stream_rows);
+        double mmap_ms = time_load(path, *in.second, num_threads, LoadMode::Mmap, reps, mmap_rows);
+
+        if (stream_rows != mmap_rows)
+            std::cerr << "Row count mismatch for " << in.first << ": " << stream_rows
+                      << " vs " << mmap_rows << std::endl;
+
+        std::cout << std::left << std::setw(10) << in.first << std::right
+                  << std::setw(12) << mmap_rows << std::setw(12) << stream_ms << std::setw(12) << mmap_ms
+                  << std::setw(12) << (stream_ms > 0 ? mb * 1000.0 / stream_ms : 0.0)
+                  << std::setw(12) << (mmap_ms > 0 ? mb * 1000.0 / mmap_ms : 0.0)
+                  << std::setw(9) << (mmap_ms > 0 ? stream_ms / mmap_ms : 0.0) << "x" << std::endl;
+    }
+    return 0;
+}
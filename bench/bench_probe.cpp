@@ -0,0 +1,97 @@
+// Compares the scalar lineitem probe loop against the SIMD kernel, and the
+// raw columns against the compressed table, on one thread, using a build
+// side for the given query parameters.
+//
+// Usage: tpch_bench_probe <table_path> [r_name] [start_date] [end_date] [repetitions]
+#include "query5.hpp"
+#include "probe_kernels.hpp"
+#include "thread_pool.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+
+using Clock = std::chrono::high_resolution_clock;
+
+namespace {
+
+// Best single-thread time in ms of probing the whole table with probe(acc)
+template <typename Probe>
+double time_probe(bool simd, int reps, NationAccumulator& acc, Probe&& probe) {
+    g_config.simd_probe = simd;
+    double best = 0.0;
+    for (int r = 0; r < reps; ++r) {
+        acc = NationAccumulator();
+        auto t0 = Clock::now();
+        probe(acc);
+        auto t1 = Clock::now();
+        double elapsed = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (r == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <table_path> [r_name] [start_date] [end_date] [repetitions]" << std::endl;
+        return 1;
+    }
+    std::string table_path = argv[1];
+    std::string r_name = argc > 2 ? argv[2] : "ASIA";
+    std::string start_date = argc > 3 ? argv[3] : "1994-01-01";
+    std::string end_date = argc > 4 ? argv[4] : "1995-01-01";
+    int reps = argc > 5 ? std::stoi(argv[5]) : 5;
+
+    CustomerSOA customer;
+    OrdersSOA orders;
+    LineItemSOA lineitem;
+    SupplierSOA supplier;
+    NationSOA nation;
+    RegionSOA region;
+    if (!readTPCHData(table_path, customer, orders, lineitem, supplier, nation, region))
+        return 1;
+
+    Q5BuildSide build;
+    if (!buildQ5BuildSide(r_name, start_date, end_date, 1, customer, orders, supplier, nation, region, build)) {
+        std::cerr << "Failed to build Q5 join state." << std::endl;
+        return 1;
+    }
+
+    NationAccumulator scalar_acc, simd_acc;
+    auto probe_raw = [&](NationAccumulator& acc) { probe_lineitem(0, lineitem.size(), lineitem, build, acc); };
+    double scalar_ms = time_probe(false, reps, scalar_acc, probe_raw);
+    double simd_ms = time_probe(true, reps, simd_acc, probe_raw);
+
+    bool same = true;
+    for (int n = 0; n < kMaxNations; ++n)
+        same = same && scalar_acc.revenue[n] == simd_acc.revenue[n] && scalar_acc.rows[n] == simd_acc.rows[n];
+
+    PackedLineItemSOA packed;
+    NationAccumulator packed_acc;
+    double packed_ms = 0.0;
+    bool packed_ok = packed.pack(lineitem, shared_pool(1));
+    if (packed_ok) {
+        PackedProbeBuffer buffer;
+        packed_ms = time_probe(true, reps, packed_acc, [&](NationAccumulator& acc) {
+            buffer.index = SIZE_MAX;   // decode every block on every rep
+            probe_lineitem(0, packed.size(), packed, build, buffer, acc);
+        });
+        for (int n = 0; n < kMaxNations; ++n)
+            same = same && scalar_acc.revenue[n] == packed_acc.revenue[n] && scalar_acc.rows[n] == packed_acc.rows[n];
+    }
+
+    double mrows = lineitem.size() / 1e6;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "rows: " << lineitem.size() << std::endl;
+    std::cout << "scalar: " << scalar_ms << " ms (" << mrows / (scalar_ms / 1000.0) << " Mrows/s)" << std::endl;
+    std::cout << "simd:   " << simd_ms << " ms (" << mrows / (simd_ms / 1000.0) << " Mrows/s)"
+              << (select_probe_kernel() ? "" : " [no SIMD kernel on this CPU, scalar fallback]") << std::endl;
+    if (packed_ok)
+        std::cout << "packed: " << packed_ms << " ms (" << mrows / (packed_ms / 1000.0) << " Mrows/s, "
+                  << packed.bytes() / (1024 * 1024) << " MB)" << std::endl;
+    std::cout << "speedup: " << scalar_ms / simd_ms << "x, results " << (same ? "match" : "DIFFER") << std::endl;
+    return same ? 0 : 1;
+}
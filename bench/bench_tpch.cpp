@@ -0,0 +1,320 @@
+// Self-contained benchmark suite: generates TPC-H tables in process at the
+// given scale factor (see tpch_datagen.hpp), then times
+//   parse:   each table with each loader (getline/istringstream vs mmap)
+//   q5:      each Q5 phase, from the phase profiler
+//   scaling: the full load and the query at 1, 2, 4, ... threads
+//   ops:     a hash group-by (revenue per l_suppkey) from the operator library
+// No dbgen files are needed, so runs are comparable on any Linux box.
+//
+// Usage: tpch_bench [scale_factor] [max_threads] [repetitions] [all|parse|q5|scaling|ops]
+#include "query5.hpp"
+#include "profiler.hpp"
+#include "operators.hpp"
+#include "tpch_datagen.hpp"
+#include "bench_util.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+
+using bench::Clock;
+using bench::file_mb;
+using bench::ms_since;
+using bench::time_load;
+
+namespace {
+
+const char* const kTables[] = {"customer", "orders", "lineitem", "supplier", "nation", "region"};
+
+// Q5 parameters every benchmark query uses
+const char* const kRegion = "ASIA";
+const char* const kStartDate = "1994-01-01";
+const char* const kEndDate = "1995-01-01";
+
+// Swallows std::cout while the engine's progress messages would drown the tables
+class QuietCout {
+public:
+    QuietCout() : old_(std::cout.rdbuf(&sink_)) {}
+    ~QuietCout() { std::cout.rdbuf(old_); }
+
+private:
+    struct NullBuf : std::streambuf {
+        int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    };
+    NullBuf sink_;
+    std::streambuf* old_;
+};
+
+struct LoadedTables {
+    CustomerSOA customer;
+    OrdersSOA orders;
+    LineItemSOA lineitem;
+    SupplierSOA supplier;
+    NationSOA nation;
+    RegionSOA region;
+
+    bool load(const std::string& table_path) {
+        QuietCout quiet;
+        return readTPCHData(table_path, customer, orders, lineitem, supplier, nation, region);
+    }
+
+    bool query(int num_threads, std::map<std::string, double>& results) const {
+        QuietCout quiet;
+        results.clear();
+        return executeQuery5(kRegion, kStartDate, kEndDate, num_threads, customer, orders, lineitem,
+                             supplier, nation, region, results);
+    }
+};
+
+bool bench_parse(const std::string& table_path, int num_threads, int reps) {
+    LoadedTables prototypes;
+    const tables* inputs[] = {&prototypes.customer, &prototypes.orders, &prototypes.lineitem,
+                              &prototypes.supplier, &prototypes.nation, &prototypes.region};
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n== parse (" << num_threads << " threads, best of " << reps << ") ==" << std::endl;
+    std::cout << std::left << std::setw(10) << "table" << std::right << std::setw(12) << "rows"
+              << std::setw(10) << "MB" << std::setw(12) << "stream ms" << std::setw(12) << "mmap ms"
+              << std::setw(13) << "stream MB/s" << std::setw(12) << "mmap MB/s" << std::endl;
+
+    bool ok = true;
+    for (size_t t = 0; t < 6; ++t) {
+        std::string path = datagen::table_file(table_path, kTables[t]);
+        double mb = file_mb(path);
+        int stream_rows = 0, mmap_rows = 0;
+        double stream_ms = time_load(path, *inputs[t], num_threads, LoadMode::Stream, reps, stream_rows);
+        double mmap_ms = time_load(path, *inputs[t], num_threads, LoadMode::Mmap, reps, mmap_rows);
+        if (stream_rows != mmap_rows) {
+            std::cerr << "Row count mismatch for " << kTables[t] << ": " << stream_rows << " vs "
+                      << mmap_rows << std::endl;
+            ok = false;
+        }
+        std::cout << std::left << std::setw(10) << kTables[t] << std::right << std::setw(12) << mmap_rows
+                  << std::setw(10) << mb << std::setw(12) << stream_ms << std::setw(12) << mmap_ms
+                  << std::setw(13) << (stream_ms > 0 ? mb * 1000.0 / stream_ms : 0.0)
+                  << std::setw(12) << (mmap_ms > 0 ? mb * 1000.0 / mmap_ms : 0.0) << std::endl;
+    }
+    return ok;
+}
+
+// Per-phase best times of reps queries, taken from the phase profiler
+bool bench_q5(const LoadedTables& data, int num_threads, int reps) {
+    std::map<std::string, PhaseRecord> best;
+    std::vector<std::string> order;
+    double best_total = 0.0;
+
+    for (int r = 0; r < reps; ++r) {
+        clear_recorded_phases();
+        std::map<std::string, double> results;
+        auto t0 = Clock::now();
+        if (!data.query(num_threads, results)) return false;
+        double total = ms_since(t0);
+        if (r == 0 || total < best_total) best_total = total;
+
+        for (const PhaseRecord& p : recorded_phases()) {
+            auto it = best.find(p.name);
+            if (it == best.end()) {
+                order.push_back(p.name);
+                best[p.name] = p;
+            } else if (p.wall_ms < it->second.wall_ms) {
+                it->second = p;
+            }
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n== q5 phases (" << num_threads << " threads, best of " << reps << ") ==" << std::endl;
+    std::cout << std::left << std::setw(16) << "phase" << std::right << std::setw(10) << "ms"
+              << std::setw(12) << "rows in" << std::setw(12) << "rows out" << std::setw(12) << "Mrows/s"
+              << std::setw(10) << "GB/s" << std::setw(8) << "skew" << std::endl;
+    for (const std::string& name : order) {
+        const PhaseRecord& p = best[name];
+        double seconds = p.wall_ms / 1000.0;
+        double max_busy = 0.0, sum_busy = 0.0;
+        for (double b : p.thread_busy_ms) {
+            max_busy = std::max(max_busy, b);
+            sum_busy += b;
+        }
+        double mean_busy = p.thread_busy_ms.empty() ? 0.0 : sum_busy / p.thread_busy_ms.size();
+        std::cout << std::left << std::setw(16) << name << std::right << std::setw(10) << p.wall_ms
+                  << std::setw(12) << p.rows_in << std::setw(12) << p.rows_out
+                  << std::setw(12) << (seconds > 0 ? p.rows_in / 1e6 / seconds : 0.0)
+                  << std::setw(10) << (seconds > 0 ? p.bytes / 1e9 / seconds : 0.0)
+                  << std::setw(8) << (mean_busy > 0 ? max_busy / mean_busy : 1.0) << std::endl;
+    }
+    std::cout << std::left << std::setw(16) << "total" << std::right << std::setw(10) << best_total << std::endl;
+    return true;
+}
+
+// Load and query wall times from 1 thread up to max_threads; every thread
+// count must give the single-thread answer
+bool bench_scaling(const std::string& table_path, int max_threads, int reps) {
+    std::vector<int> counts;
+    for (int t = 1; t < max_threads; t *= 2) counts.push_back(t);
+    counts.push_back(max_threads);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n== scaling (best of " << reps << ") ==" << std::endl;
+    std::cout << std::right << std::setw(8) << "threads" << std::setw(12) << "load ms" << std::setw(10) << "speedup"
+              << std::setw(12) << "query ms" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::endl;
+
+    std::map<std::string, double> reference;
+    double load_1 = 0.0, query_1 = 0.0;
+    bool ok = true;
+    for (int threads : counts) {
+        g_config.num_threads = threads;
+        double load_ms = 0.0, query_ms = 0.0;
+        std::unique_ptr<LoadedTables> data;
+        for (int r = 0; r < reps; ++r) {
+            auto fresh = std::make_unique<LoadedTables>();
+            auto t0 = Clock::now();
+            if (!fresh->load(table_path)) return false;
+            double elapsed = ms_since(t0);
+            if (r == 0 || elapsed < load_ms) load_ms = elapsed;
+            data = std::move(fresh);
+        }
+
+        std::map<std::string, double> results;
+        for (int r = 0; r < reps; ++r) {
+            auto t0 = Clock::now();
+            if (!data->query(threads, results)) return false;
+            double elapsed = ms_since(t0);
+            if (r == 0 || elapsed < query_ms) query_ms = elapsed;
+        }
+
+        if (threads == 1) {
+            reference = results;
+            load_1 = load_ms;
+            query_1 = query_ms;
+        } else if (results != reference) {
+            std::cerr << "Results at " << threads << " threads differ from 1 thread" << std::endl;
+            ok = false;
+        }
+        double query_speedup = query_ms > 0 ? query_1 / query_ms : 0.0;
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(8) << threads << std::setw(12) << load_ms
+                  << std::setw(9) << (load_ms > 0 ? load_1 / load_ms : 0.0) << "x"
+                  << std::setw(12) << query_ms << std::setw(9) << query_speedup << "x"
+                  << std::setw(11) << 100.0 * query_speedup / threads << "%" << std::endl;
+    }
+    return ok;
+}
+
+// Discounted revenue per l_suppkey of the rows with l_discount >= 0.05, as
+// scan + filter + HashAggregate; the groups must add up to a serial sum
+bool bench_ops(const LoadedTables& data, int num_threads, int reps) {
+    const LineItemSOA& lineitem = data.lineitem;
+    ThreadPool& pool = shared_pool(num_threads);
+    auto keep = [&](size_t row) { return lineitem.l_discount[row] >= 5; };
+
+    int64_t expected_sum = 0, expected_rows = 0;
+    for (int i = 0; i < lineitem.size(); ++i) {
+        if (!keep(i)) continue;
+        expected_sum += discounted_revenue(lineitem.l_extendedprice[i], lineitem.l_discount[i]);
+        ++expected_rows;
+    }
+
+    double best = 0.0;
+    size_t groups = 0;
+    bool ok = true;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = Clock::now();
+        ops::HashAggregate<int, int64_t> revenue(pool.size());
+        ops::scan(pool, lineitem.size(), [&](size_t begin, size_t end, int worker) {
+            ops::Selection sel;
+            int suppkeys[ops::kBatchRows];
+            ops::filter(begin, end, keep, sel);
+            for (uint32_t j = 0; j < sel.count; ++j)
+                suppkeys[j] = lineitem.l_suppkey[sel.row(j)];
+            ops::aggregate(sel, suppkeys,
+                           [&](size_t row) {
+                               return discounted_revenue(lineitem.l_extendedprice[row], lineitem.l_discount[row]);
+                           },
+                           revenue.local(worker));
+        });
+        auto totals = revenue.result();
+        double elapsed = ms_since(t0);
+        if (r == 0 || elapsed < best) best = elapsed;
+
+        int64_t sum = 0, rows = 0;
+        for (const auto& [key, g] : totals) {
+            sum += g.sum;
+            rows += g.rows;
+        }
+        groups = totals.size();
+        if (sum != expected_sum || rows != expected_rows) {
+            std::cerr << "Hash group-by totals differ from the serial sum" << std::endl;
+            ok = false;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n== ops (" << num_threads << " threads, best of " << reps << ") ==" << std::endl;
+    std::cout << "hash group-by revenue per l_suppkey: " << best << " ms, " << groups << " groups, "
+              << (best > 0 ? lineitem.size() / 1e3 / best : 0.0) << " Mrows/s" << std::endl;
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--help") {
+        std::cerr << "Usage: " << argv[0] << " [scale_factor] [max_threads] [repetitions] [all|parse|q5|scaling|ops]" << std::endl;
+        return 1;
+    }
+    double sf = argc > 1 ? std::stod(argv[1]) : 0.1;
+    int hw = static_cast<int>(std::thread::hardware_concurrency());
+    int max_threads = argc > 2 ? std::stoi(argv[2]) : (hw > 0 ? hw : 1);
+    int reps = argc > 3 ? std::stoi(argv[3]) : 3;
+    std::string suite = argc > 4 ? argv[4] : "all";
+    if (max_threads < 1) max_threads = 1;
+    if (reps < 1) reps = 1;
+
+    char dir_template[] = "/tmp/tpch_bench.XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        std::cerr << "Cannot create a temporary directory" << std::endl;
+        return 1;
+    }
+    const std::string dir = dir_template;
+    const std::string table_path = dir + "/sf";
+
+    auto t0 = Clock::now();
+    int64_t lineitem_rows = datagen::generate(table_path, sf, 1);
+    if (lineitem_rows < 0) {
+        std::cerr << "Cannot write generated tables under " << dir << std::endl;
+        return 1;
+    }
+    double total_mb = 0.0;
+    for (const char* t : kTables)
+        total_mb += file_mb(datagen::table_file(table_path, t));
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Generated SF" << sf << ": " << lineitem_rows << " lineitem rows, " << total_mb
+              << " MB in " << ms_since(t0) << " ms" << std::endl;
+
+    bool ok = true;
+    g_config.num_threads = max_threads;
+    if (suite == "all" || suite == "parse")
+        ok = bench_parse(table_path, max_threads, reps) && ok;
+    if (suite == "all" || suite == "q5" || suite == "ops") {
+        LoadedTables data;
+        enable_profiling(false);
+        ok = data.load(table_path) && ok;
+        if (suite != "ops")
+            ok = bench_q5(data, max_threads, reps) && ok;
+        if (suite != "q5")
+            ok = bench_ops(data, max_threads, reps) && ok;
+    }
+    if (suite == "all" || suite == "scaling")
+        ok = bench_scaling(table_path, max_threads, reps) && ok;
+
+    for (const char* t : kTables)
+        std::remove(datagen::table_file(table_path, t).c_str());
+    rmdir(dir.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+#pragma once
+// Timing helpers shared by the benchmark executables
+#include <chrono>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include "query5.hpp"
+
+namespace bench {
+
+using Clock = std::chrono::high_resolution_clock;
+
+inline double ms_since(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// Size of a file in MB, 0 if it cannot be stat'ed
+inline double file_mb(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return 0.0;
+    return st.st_size / (1024.0 * 1024.0);
+}
+
+// Best wall time in milliseconds over reps loads of one table with one
+// loader; rows gets the row count of the last load
+inline double time_load(const std::string& path, const tables& prototype, int num_threads,
+                        LoadMode mode, int reps, int& rows) {
+    double best = 0.0;
+    for (int r = 0; r < reps; ++r) {
+        std::unique_ptr<tables> table = prototype.create_empty();
+        auto t0 = Clock::now();
+        load_data_multithreaded(path, *table, num_threads, mode);
+        double elapsed = ms_since(t0);
+        if (r == 0 || elapsed < best)
+            best = elapsed;
+        rows = table->size();
+    }
+    return best;
+}
+
+} // namespace bench
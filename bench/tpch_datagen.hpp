@@ -0,0 +1,258 @@
+#pragma once
+// Deterministic in-process TPC-H generator for the benchmarks. Writes the
+// six .tbl files Q5 reads at any scale factor, with dbgen's row counts, key
+// layout (sparse orderkeys, no custkey divisible by 3 in orders) and field
+// formats, so the loaders parse the same shapes of rows as on real dbgen
+// output. Values are not dbgen's: the same (scale factor, seed) always gives
+// the same files, but not the files dbgen would write.
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "tbl_parser.hpp"
+
+namespace datagen {
+
+// splitmix64: small, fast and good enough for uniform test data
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [lo, hi]
+    int64_t uniform(int64_t lo, int64_t hi) {
+        return lo + static_cast<int64_t>(next() % static_cast<uint64_t>(hi - lo + 1));
+    }
+
+private:
+    uint64_t state_;
+};
+
+constexpr const char* kRegions[] = {"AFRICA", "AMERICA", "ASIA", "EUROPE", "MIDDLE EAST"};
+
+struct NationDef {
+    const char* name;
+    int regionkey;
+};
+
+constexpr NationDef kNations[] = {
+    {"ALGERIA", 0}, {"ARGENTINA", 1}, {"BRAZIL", 1}, {"CANADA", 1}, {"EGYPT", 4},
+    {"ETHIOPIA", 0}, {"FRANCE", 3}, {"GERMANY", 3}, {"INDIA", 2}, {"INDONESIA", 2},
+    {"IRAN", 4}, {"IRAQ", 4}, {"JAPAN", 2}, {"JORDAN", 4}, {"KENYA", 0},
+    {"MOROCCO", 0}, {"MOZAMBIQUE", 0}, {"PERU", 1}, {"CHINA", 2}, {"ROMANIA", 3},
+    {"SAUDI ARABIA", 4}, {"VIETNAM", 2}, {"RUSSIA", 3}, {"UNITED KINGDOM", 3}, {"UNITED STATES", 1},
+};
+
+constexpr int kNumNations = 25;
+
+// dbgen's o_orderdate range: 1992-01-01 .. 1998-08-02
+inline int min_order_day() { return tbl::days_from_civil(1992, 1, 1); }
+inline int max_order_day() { return tbl::days_from_civil(1998, 8, 2); }
+
+// Rows per table at scale factor sf, at least one each
+struct TableSizes {
+    int64_t supplier;
+    int64_t customer;
+    int64_t orders;
+
+    explicit TableSizes(double sf)
+        : supplier(scaled(10000, sf)), customer(scaled(150000, sf)), orders(scaled(1500000, sf)) {}
+
+private:
+    static int64_t scaled(int64_t base, double sf) {
+        int64_t n = static_cast<int64_t>(base * sf);
+        return n < 1 ? 1 : n;
+    }
+};
+
+// Appends rows into a buffer that is written out a megabyte at a time
+class TblWriter {
+public:
+    explicit TblWriter(const std::string& path) : out_(path, std::ios::binary) {
+        buf_.reserve(kFlushBytes + 4096);
+    }
+
+    ~TblWriter() { flush(); }
+
+    bool ok() const { return static_cast<bool>(out_); }
+
+    TblWriter& field(int64_t v) {
+        char tmp[24];
+        int n = std::snprintf(tmp, sizeof(tmp), "%lld", static_cast<long long>(v));
+        buf_.append(tmp, static_cast<size_t>(n));
+        buf_ += '|';
+        return *this;
+    }
+
+    TblWriter& field(const char* s) {
+        buf_ += s;
+        buf_ += '|';
+        return *this;
+    }
+
+    // Hundredths as a decimal with two places
+    TblWriter& cents(int64_t v) {
+        char tmp[32];
+        const long long a = v < 0 ? -static_cast<long long>(v) : static_cast<long long>(v);
+        int n = std::snprintf(tmp, sizeof(tmp), "%s%lld.%02lld", v < 0 ? "-" : "", a / 100, a % 100);
+        buf_.append(tmp, static_cast<size_t>(n));
+        buf_ += '|';
+        return *this;
+    }
+
+    // Days since the epoch as YYYY-MM-DD (Hinnant's civil_from_days)
+    TblWriter& date(int days) {
+        days += 719468;
+        const int era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(days - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+        const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+        const int y = static_cast<int>(yoe) + era * 400 + (m <= 2);
+        char tmp[16];
+        int n = std::snprintf(tmp, sizeof(tmp), "%04d-%02u-%02u", y, m, d);
+        buf_.append(tmp, static_cast<size_t>(n));
+        buf_ += '|';
+        return *this;
+    }
+
+    // A comment of random length, so rows vary in width like dbgen's
+    TblWriter& comment(Rng& rng, int min_len, int max_len) {
+        static const char kText[] =
+            "furiously regular deposits sleep carefully final packages haggle slyly "
+            "ironic accounts nag quickly pending requests wake blithely bold theodolites ";
+        int len = static_cast<int>(rng.uniform(min_len, max_len));
+        int start = static_cast<int>(rng.uniform(0, static_cast<int64_t>(sizeof(kText)) - 2 - max_len));
+        buf_.append(kText + start, static_cast<size_t>(len));
+        buf_ += '|';
+        return *this;
+    }
+
+    void end_row() {
+        buf_ += '\n';
+        if (buf_.size() >= kFlushBytes) flush();
+    }
+
+    void flush() {
+        out_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+        buf_.clear();
+    }
+
+private:
+    static constexpr size_t kFlushBytes = 1 << 20;
+    std::ofstream out_;
+    std::string buf_;
+};
+
+inline std::string table_file(const std::string& table_path, const char* table) {
+    return table_path + "\\" + table + ".tbl";
+}
+
+// Writes region, nation, supplier, customer, orders and lineitem for scale
+// factor sf under table_path (named like the loader expects). Returns the
+// number of lineitem rows, or -1 if a file cannot be written.
+inline int64_t generate(const std::string& table_path, double sf, uint64_t seed)
+{
+    const TableSizes sizes(sf);
+    Rng rng(seed);
+
+    {
+        TblWriter w(table_file(table_path, "region"));
+        for (int r = 0; r < 5; ++r) {
+            w.field(r).field(kRegions[r]).comment(rng, 20, 60);
+            w.end_row();
+        }
+        if (!w.ok()) return -1;
+    }
+    {
+        TblWriter w(table_file(table_path, "nation"));
+        for (int n = 0; n < kNumNations; ++n) {
+            w.field(n).field(kNations[n].name).field(kNations[n].regionkey).comment(rng, 30, 110);
+            w.end_row();
+        }
+        if (!w.ok()) return -1;
+    }
+    {
+        TblWriter w(table_file(table_path, "supplier"));
+        for (int64_t s = 1; s <= sizes.supplier; ++s) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "Supplier#%09lld", static_cast<long long>(s));
+            w.field(s).field(name).comment(rng, 10, 40).field(rng.uniform(0, kNumNations - 1))
+             .field("27-918-335-1736").cents(rng.uniform(-99999, 999999)).comment(rng, 25, 100);
+            w.end_row();
+        }
+        if (!w.ok()) return -1;
+    }
+    {
+        static const char* kSegments[] = {"AUTOMOBILE", "BUILDING", "FURNITURE", "HOUSEHOLD", "MACHINERY"};
+        TblWriter w(table_file(table_path, "customer"));
+        for (int64_t c = 1; c <= sizes.customer; ++c) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "Customer#%09lld", static_cast<long long>(c));
+            w.field(c).field(name).comment(rng, 10, 40).field(rng.uniform(0, kNumNations - 1))
+             .field("25-989-741-2988").cents(rng.uniform(-99999, 999999))
+             .field(kSegments[rng.uniform(0, 4)]).comment(rng, 29, 116);
+            w.end_row();
+        }
+        if (!w.ok()) return -1;
+    }
+
+    static const char* kPriorities[] = {"1-URGENT", "2-HIGH", "3-MEDIUM", "4-NOT SPECIFIED", "5-LOW"};
+    static const char* kInstructs[] = {"DELIVER IN PERSON", "COLLECT COD", "NONE", "TAKE BACK RETURN"};
+    static const char* kModes[] = {"REG AIR", "AIR", "RAIL", "SHIP", "TRUCK", "MAIL", "FOB"};
+
+    TblWriter orders(table_file(table_path, "orders"));
+    TblWriter lineitem(table_file(table_path, "lineitem"));
+    Rng line_rng(seed ^ 0x5DEECE66Dull);
+    const int lo_day = min_order_day(), hi_day = max_order_day();
+    int64_t lineitem_rows = 0;
+
+    for (int64_t i = 0; i < sizes.orders; ++i) {
+        // dbgen uses the first 8 keys of every 32
+        int64_t orderkey = (i / 8) * 32 + (i % 8) + 1;
+        // and never gives an order to a customer whose key is divisible by 3
+        int64_t custkey = rng.uniform(1, sizes.customer);
+        if (custkey % 3 == 0) custkey = custkey > 1 ? custkey - 1 : 1;
+        int orderdate = static_cast<int>(rng.uniform(lo_day, hi_day));
+        char clerk[32];
+        std::snprintf(clerk, sizeof(clerk), "Clerk#%09lld", static_cast<long long>(rng.uniform(1, 1000)));
+
+        int lines = static_cast<int>(line_rng.uniform(1, 7));
+        int64_t total = 0;
+        for (int l = 1; l <= lines; ++l) {
+            int64_t quantity = line_rng.uniform(1, 50);
+            int64_t price = quantity * line_rng.uniform(90000, 200000);   // cents
+            int64_t discount = line_rng.uniform(0, 10);
+            int ship = orderdate + static_cast<int>(line_rng.uniform(1, 121));
+            total += price;
+            lineitem.field(orderkey).field(line_rng.uniform(1, 20 * sizes.supplier))
+                    .field(line_rng.uniform(1, sizes.supplier)).field(l).field(quantity)
+                    .cents(price).cents(discount).cents(line_rng.uniform(0, 8))
+                    .field(ship > tbl::days_from_civil(1995, 6, 17) ? "N" : "R").field("O")
+                    .date(ship).date(orderdate + static_cast<int>(line_rng.uniform(30, 90)))
+                    .date(ship + static_cast<int>(line_rng.uniform(1, 30)))
+                    .field(kInstructs[line_rng.uniform(0, 3)]).field(kModes[line_rng.uniform(0, 6)])
+                    .comment(line_rng, 10, 43);
+            lineitem.end_row();
+        }
+        lineitem_rows += lines;
+
+        orders.field(orderkey).field(custkey).field("O").cents(total).date(orderdate)
+              .field(kPriorities[rng.uniform(0, 4)]).field(clerk).field(int64_t(0)).comment(rng, 19, 78);
+        orders.end_row();
+    }
+    orders.flush();
+    lineitem.flush();
+    if (!orders.ok() || !lineitem.ok()) return -1;
+    return lineitem_rows;
+}
+
+} // namespace datagen
@@ -0,0 +1,203 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include "mapped_file.hpp"
+
+// Binary columnar cache of a loaded SoA table, stored next to its .tbl file.
+//
+// Layout (all fields little endian, every column payload 64-byte aligned):
+//   CacheHeader
+//   per column: ColumnHeader, padding, payload
+// Fixed-width columns store their raw array. String columns store
+// rows+1 uint64 offsets followed by the concatenated bytes.
+//
+// The header records the size and mtime of the source .tbl; a cache whose
+// source has changed, or whose schema version differs, is ignored.
+
+constexpr uint32_t kCacheSchemaVersion = 3;   // 2: o_orderdate as int32 days, 3: money as int64 cents
+constexpr char kCacheMagic[8] = {'T', 'P', 'C', 'H', 'C', 'O', 'L', '\0'};
+
+enum class ColumnType : uint32_t {
+    Int32 = 0,
+    Float64 = 1,
+    String = 2,
+    Int64 = 3,
+};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_columns;
+    uint64_t rows;
+    uint64_t source_size;
+    int64_t source_mtime_ns;
+};
+
+struct ColumnHeader {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t bytes;
+};
+
+template <typename T> struct ColumnTypeOf;
+template <> struct ColumnTypeOf<int> { static constexpr ColumnType value = ColumnType::Int32; };
+template <> struct ColumnTypeOf<double> { static constexpr ColumnType value = ColumnType::Float64; };
+template <> struct ColumnTypeOf<int64_t> { static constexpr ColumnType value = ColumnType::Int64; };
+
+// Streams columns straight to the cache file. The header slot at the front
+// is zero until finish() seeks back and fills it in, so a partially written
+// file never passes the magic check.
+class ColumnWriter {
+public:
+    explicit ColumnWriter(std::ostream& out) : out_(out) {
+        const char zero[sizeof(CacheHeader)] = {};
+        append(zero, sizeof(zero));
+    }
+
+    template <typename T, typename Alloc>
+    void write(const std::vector<T, Alloc>& column) {
+        static_assert(std::is_trivially_copyable<T>::value, "fixed-width column expected");
+        begin_column(ColumnTypeOf<T>::value, column.size() * sizeof(T));
+        append(column.data(), column.size() * sizeof(T));
+        ++num_columns_;
+    }
+
+    void write(const std::vector<std::string>& column) {
+        std::vector<uint64_t> offsets(column.size() + 1, 0);
+        for (size_t i = 0; i < column.size(); ++i)
+            offsets[i + 1] = offsets[i] + column[i].size();
+
+        begin_column(ColumnType::String, offsets.size() * sizeof(uint64_t) + offsets.back());
+        append(offsets.data(), offsets.size() * sizeof(uint64_t));
+        for (const auto& s : column)
+            append(s.data(), s.size());
+        ++num_columns_;
+    }
+
+    // Writes the header over its slot; false if any write failed
+    bool finish(const CacheHeader& h) {
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out_.flush();
+        return static_cast<bool>(out_);
+    }
+
+    uint32_t num_columns() const { return num_columns_; }
+
+private:
+    void pad_to_64() {
+        static const char zero[64] = {};
+        size_t padded = (offset_ + 63) & ~uint64_t(63);
+        append(zero, padded - offset_);
+    }
+
+    void begin_column(ColumnType type, uint64_t payload_bytes) {
+        ColumnHeader h{static_cast<uint32_t>(type), 0, payload_bytes};
+        append(&h, sizeof(h));
+        pad_to_64();
+    }
+
+    void append(const void* p, size_t n) {
+        out_.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+        offset_ += n;
+    }
+
+    std::ostream& out_;
+    uint64_t offset_ = 0;
+    uint32_t num_columns_ = 0;
+};
+
+// Reads columns back out of a mapped cache file. Any mismatch between the
+// stored column and the requested type marks the reader as failed.
+class ColumnReader {
+public:
+    ColumnReader() = default;
+    ColumnReader(const char* p, const char* end, uint64_t rows) : p_(p), end_(end), rows_(rows) {}
+
+    template <typename T, typename Alloc>
+    bool read(std::vector<T, Alloc>& column) {
+        const char* payload = next_column(ColumnTypeOf<T>::value, rows_ * sizeof(T));
+        if (!payload) return false;
+        column.resize(rows_);
+        if (rows_ > 0)
+            std::memcpy(column.data(), payload, rows_ * sizeof(T));
+        return true;
+    }
+
+    bool read(std::vector<std::string>& column) {
+        const char* payload = next_column(ColumnType::String, 0);
+        if (!payload) return false;
+        const uint64_t* offsets = reinterpret_cast<const uint64_t*>(payload);
+        const char* chars = payload + (rows_ + 1) * sizeof(uint64_t);
+        if (chars + offsets[rows_] > end_) return ok_ = false;
+
+        column.clear();
+        column.reserve(rows_);
+        for (uint64_t i = 0; i < rows_; ++i)
+            column.emplace_back(chars + offsets[i], offsets[i + 1] - offsets[i]);
+        return true;
+    }
+
+    // The next fixed-width column in place in the mapping, without a copy;
+    // nullptr if it does not match
+    template <typename T>
+    const T* view() {
+        return reinterpret_cast<const T*>(next_column(ColumnTypeOf<T>::value, rows_ * sizeof(T)));
+    }
+
+    bool ok() const { return ok_; }
+    uint64_t rows() const { return rows_; }
+
+private:
+    // Returns the payload of the next column, or nullptr if it does not match
+    const char* next_column(ColumnType type, uint64_t expected_bytes) {
+        if (!ok_ || p_ + sizeof(ColumnHeader) > end_) return fail();
+        ColumnHeader h;
+        std::memcpy(&h, p_, sizeof(h));
+        if (h.type != static_cast<uint32_t>(type)) return fail();
+        if (type != ColumnType::String && h.bytes != expected_bytes) return fail();
+
+        const char* payload = align_64(p_ + sizeof(h));
+        if (payload + h.bytes > end_) return fail();
+        if (type == ColumnType::String && h.bytes < (rows_ + 1) * sizeof(uint64_t)) return fail();
+        p_ = payload + h.bytes;
+        return payload;
+    }
+
+    const char* fail() {
+        ok_ = false;
+        return nullptr;
+    }
+
+    // Payloads are aligned relative to the start of the file, and mmap
+    // places the file on a page boundary
+    static const char* align_64(const char* p) {
+        uintptr_t v = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<const char*>((v + 63) & ~uintptr_t(63));
+    }
+
+    const char* p_ = nullptr;
+    const char* end_ = nullptr;
+    uint64_t rows_ = 0;
+    bool ok_ = true;
+};
+
+class tables;
+
+// Path of the cache file that belongs to a .tbl file
+std::string cache_path_for(const std::string& tbl_path);
+
+// Maps the cache of tbl_path if one exists and is still valid for table's
+// columns, and points reader at its first column
+bool open_cached_table(const std::string& tbl_path, const tables& table, MappedFile& mapped,
+                       ColumnReader& reader);
+
+// Fills table from the cache of tbl_path if one exists and is still valid
+bool load_cached_table(const std::string& tbl_path, tables& table);
+
+// Writes the cache for tbl_path; failures only cost the next run a reparse
+bool save_cached_table(const std::string& tbl_path, const tables& table);
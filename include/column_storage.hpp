@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Storage for the fixed-width table columns.
+//
+// Columns of at least kMappedColumnBytes get their own 2 MB-aligned
+// anonymous mapping instead of a heap block, so they can be backed by huge
+// pages (fewer TLB misses in the lineitem scan) and are returned to the OS
+// whole when freed. Elements are default-initialized: resize() touches no
+// page, fresh mappings already read as zero, and each loader thread faults
+// in only the slice of rows it parses. Smaller columns use the heap.
+
+enum class HugePageMode {
+    Off,        // plain 4K pages
+    Thp,        // madvise(MADV_HUGEPAGE): transparent huge pages where enabled
+    Explicit,   // MAP_HUGETLB from the reserved pool, Thp if it is empty
+};
+
+constexpr size_t kHugePageBytes = 2u << 20;
+constexpr size_t kMappedColumnBytes = kHugePageBytes;
+
+void set_column_huge_pages(HugePageMode mode);
+HugePageMode column_huge_pages();
+
+// Mapping size for a column of `bytes`, a whole number of huge pages
+inline size_t mapped_column_bytes(size_t bytes) {
+    return (bytes + kHugePageBytes - 1) & ~(kHugePageBytes - 1);
+}
+
+// Maps / unmaps a column of at least kMappedColumnBytes; nullptr if the
+// mapping fails
+void* map_column(size_t bytes);
+void unmap_column(void* p, size_t bytes);
+
+// Mapped column bytes currently live, and of those how many came from the
+// explicit huge page pool
+size_t mapped_column_total();
+size_t mapped_column_hugetlb();
+
+template <typename T>
+struct ColumnAllocator {
+    using value_type = T;
+
+    ColumnAllocator() = default;
+    template <typename U>
+    ColumnAllocator(const ColumnAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        const size_t bytes = n * sizeof(T);
+        if (bytes >= kMappedColumnBytes) {
+            if (void* p = map_column(bytes)) return static_cast<T*>(p);
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(::operator new(bytes));
+    }
+
+    void deallocate(T* p, size_t n) {
+        const size_t bytes = n * sizeof(T);
+        if (bytes >= kMappedColumnBytes)
+            unmap_column(p, bytes);
+        else
+            ::operator delete(p);
+    }
+
+    // resize() default-initializes instead of zeroing
+    template <typename U>
+    void construct(U* p) { ::new (static_cast<void*>(p)) U; }
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+
+    template <typename U>
+    bool operator==(const ColumnAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const ColumnAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using Column = std::vector<T, ColumnAllocator<T>>;
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+// Direct-addressed key -> value index for the dense integer keys TPC-H uses
+// (custkey, suppkey, orderkey). A probe is one array load; kMissing marks
+// keys that are absent or did not qualify.
+//
+// Each key is written by at most one row, so threads that own disjoint row
+// ranges can set() into the same index concurrently without merging.
+template <typename V = int32_t>
+class DenseIndex {
+public:
+    static constexpr V kMissing = static_cast<V>(-1);
+
+    // Extra missing slots after the last key, so SIMD kernels may gather a
+    // 32-bit word at any valid key's byte offset
+    static constexpr size_t kTailPadding = 4;
+
+    // Size the index for keys in [0, max_key] with every slot missing
+    void reset(int max_key) {
+        capacity_ = max_key < 0 ? 0 : static_cast<size_t>(max_key) + 1;
+        slots_.assign(capacity_ + kTailPadding, kMissing);
+    }
+
+    void set(int key, V value) {
+        slots_[static_cast<size_t>(key)] = value;
+    }
+
+    V get(int key) const {
+        return static_cast<size_t>(key) < capacity_ ? slots_[static_cast<size_t>(key)] : kMissing;
+    }
+
+    bool contains(int key) const {
+        return get(key) != kMissing;
+    }
+
+    size_t capacity() const { return capacity_; }
+    const V* data() const { return slots_.data(); }
+    size_t bytes() const { return slots_.size() * sizeof(V); }
+
+private:
+    std::vector<V> slots_;
+    size_t capacity_ = 0;
+};
+
+// Largest key in a key column, used to size a DenseIndex
+template <typename Alloc>
+int max_key(const std::vector<int, Alloc>& keys) {
+    return keys.empty() ? -1 : *std::max_element(keys.begin(), keys.end());
+}
+
+// Nation keys are < 25, so nation-valued indexes use one byte per slot
+using NationIndex = DenseIndex<int8_t>;
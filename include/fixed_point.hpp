@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+// Money columns in the .tbl files carry exactly two decimals, so they are kept
+// as int64 counts of hundredths: l_extendedprice in cents, l_discount in
+// percent. Integer sums are exact, which keeps the revenue totals identical
+// for any thread count or summation order.
+using Cents = int64_t;
+
+constexpr int64_t kCentScale = 100;
+
+// Revenue of one line, l_extendedprice * (1 - l_discount), scaled by 10^4
+inline int64_t discounted_revenue(Cents price, Cents discount) {
+    return price * (kCentScale - discount);
+}
+
+constexpr int64_t kRevenueScale = kCentScale * kCentScale;
+
+inline double revenue_to_double(int64_t revenue) {
+    return static_cast<double>(revenue) / kRevenueScale;
+}
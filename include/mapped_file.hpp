@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file. The mapping is released when the
+// object goes out of scope.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+
+        if (size_ > 0) {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                size_ = 0;
+                return false;
+            }
+            data_ = static_cast<const char*>(p);
+            // Chunks are parsed front to back
+            madvise(p, size_, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+        return true;
+    }
+
+    void close() {
+        if (data_)
+            munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    // Tells the kernel the page-aligned part of [begin, end) will not be read
+    // again, so streamed files do not pile up in memory
+    void release(size_t begin, size_t end) const {
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t first = (begin + page - 1) / page * page;
+        size_t last = end / page * page;
+        if (data_ && first < last)
+            madvise(const_cast<char*>(data_) + first, last - first, MADV_DONTNEED);
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+// TPC-H has 25 nations; keys index the accumulator directly
+constexpr int kMaxNations = 32;
+
+// Set of nation keys as a bitmask, e.g. the nations of the selected region
+using NationSet = uint32_t;
+
+inline bool nation_in_set(NationSet set, int nation) {
+    return static_cast<unsigned>(nation) < static_cast<unsigned>(kMaxNations) && ((set >> nation) & 1u);
+}
+
+// Per-thread Q5 group-by state: revenue (scaled by 10^4, see fixed_point.hpp)
+// and matching row count per nation key. alignas(64) keeps every thread's
+// accumulator on its own cache lines, so neighbouring threads never share one.
+struct alignas(64) NationAccumulator {
+    int64_t revenue[kMaxNations] = {};
+    int64_t rows[kMaxNations] = {};
+
+    void add(int nation, int64_t value) {
+        revenue[nation] += value;
+        rows[nation] += 1;
+    }
+
+    void merge(const NationAccumulator& other) {
+        for (int n = 0; n < kMaxNations; ++n) {
+            revenue[n] += other.revenue[n];
+            rows[n] += other.rows[n];
+        }
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "thread_pool.hpp"
+
+// NUMA placement (--numa on). Pool workers are pinned to cores in contiguous
+// blocks per node, and the pages of the contiguous block of morsels
+// ThreadPool::run deals each worker are moved to that worker's node with
+// mbind. Scans still steal, so a morsel taken from a slower worker is read
+// remotely; the placement covers every morsel a worker runs itself. Topology
+// comes from /sys and placement from raw syscalls, so nothing is linked in;
+// on one node, or where the kernel refuses, placement is skipped and the
+// query runs as before.
+
+struct NumaTopology {
+    std::vector<int> node_ids;                // kernel node numbers, nodes with CPUs only
+    std::vector<std::vector<int>> node_cpus;  // CPUs usable by this process, per node
+
+    int num_nodes() const { return static_cast<int>(node_ids.size()); }
+};
+
+const NumaTopology& numa_topology();
+
+// Topology node index (not kernel id) that worker runs on once pinned
+int numa_worker_node(int worker, int num_workers);
+
+// Pins every thread of the pool; false if an affinity call failed
+bool numa_pin_pool(ThreadPool& pool);
+
+// A column of rows fixed-width values, scanned with parallel_for(pool, rows, morsel)
+struct NumaColumn {
+    const void* data;
+    size_t width;
+};
+
+// Moves each worker's share of the columns to its node. Returns the bytes
+// placed, 0 on a single node; false in ok if mbind is unavailable.
+size_t numa_place_columns(ThreadPool& pool, const std::vector<NumaColumn>& columns, size_t rows,
+                          size_t morsel, bool& ok);
+
+// Fraction of the columns' pages (sampled) that sit on the node of the
+// worker they are dealt to; negative if page locations cannot be queried
+double numa_local_fraction(ThreadPool& pool, const std::vector<NumaColumn>& columns, size_t rows,
+                           size_t morsel);
+
+struct NumaBandwidth {
+    int node;            // kernel node id
+    int workers;
+    double local_gbs;    // reading the node's own partitions
+    double remote_gbs;   // reading the next node's partitions, 0 on one node
+};
+
+// Read bandwidth per node over the columns, each worker streaming through
+// its own partition and then through one owned by a worker on the next node.
+// Runs with ThreadPool::run_pinned so every read is timed on its own worker.
+std::vector<NumaBandwidth> numa_measure_bandwidth(ThreadPool& pool, const std::vector<NumaColumn>& columns,
+                                                  size_t rows, size_t morsel);
@@ -0,0 +1,292 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include "thread_pool.hpp"
+#include "dense_index.hpp"
+#include "key_bitmap.hpp"
+#include "partitioned_hash_index.hpp"
+
+// Reusable relational operators over SoA columns. A query is a pipeline of
+// them: a parallel batch scan hands each worker kBatchRows rows at a time,
+// filters and join probes narrow a selection vector of the surviving rows,
+// and an aggregate folds what is left into per-worker state that is merged
+// once at the end. Operators are templates over the predicate, index and
+// accumulator types, so a pipeline compiles down to tight loops per batch.
+namespace ops {
+
+// Rows per batch; a batch's selection and payload vectors stay in L1
+constexpr size_t kBatchRows = 1024;
+
+// Rows of the current batch that are still alive, as offsets from begin
+struct Selection {
+    size_t begin = 0;
+    uint32_t count = 0;
+    uint32_t rows[kBatchRows];
+
+    size_t row(uint32_t j) const { return begin + rows[j]; }
+};
+
+// Skip predicate that keeps every morsel
+struct KeepAll {
+    bool operator()(size_t, size_t) const { return false; }
+};
+
+// Calls fn(b, e) for each batch of at most kBatchRows rows of [begin, end)
+template <typename Fn>
+void batches(size_t begin, size_t end, Fn&& fn) {
+    for (size_t b = begin; b < end; b += kBatchRows)
+        fn(b, b + kBatchRows < end ? b + kBatchRows : end);
+}
+
+// Parallel batch scan of rows [0, rows): morsels go to the pool workers and
+// fn(begin, end, worker) runs once per batch of at most kBatchRows rows.
+// skip(begin, end) may drop whole morsels first (e.g. by zone map).
+template <typename Fn, typename Skip = KeepAll>
+void scan(ThreadPool& pool, size_t rows, Fn&& fn, Skip&& skip = Skip()) {
+    parallel_for(pool, rows, kRowMorsel, [&](size_t begin, size_t end, int worker) {
+        if (skip(begin, end)) return;
+        batches(begin, end, [&](size_t b, size_t e) { fn(b, e, worker); });
+    });
+}
+
+// Selects the rows of [begin, end) for which pred(row) holds. The write is
+// unconditional and only the count depends on pred, so there is no branch
+template <typename Pred>
+void filter(size_t begin, size_t end, Pred&& pred, Selection& out) {
+    out.begin = begin;
+    uint32_t n = 0;
+    for (size_t i = begin; i < end; ++i) {
+        out.rows[n] = static_cast<uint32_t>(i - begin);
+        n += static_cast<bool>(pred(i));
+    }
+    out.count = n;
+}
+
+// Keeps the selected rows for which pred(row) holds
+template <typename Pred>
+void refine(Selection& sel, Pred&& pred) {
+    uint32_t n = 0;
+    for (uint32_t j = 0; j < sel.count; ++j) {
+        uint32_t r = sel.rows[j];
+        sel.rows[n] = r;
+        n += static_cast<bool>(pred(sel.begin + r));
+    }
+    sel.count = n;
+}
+
+// Semi-join of [begin, end) against a key bitmap, eight keys per test
+inline void semi_join(const KeyBitmap& filter, const int* keys, size_t begin, size_t end, Selection& out) {
+    out.begin = begin;
+    uint32_t n = 0;
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        unsigned mask = filter.test8(keys + i);
+        while (mask) {
+            out.rows[n++] = static_cast<uint32_t>(i - begin) + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    for (; i < end; ++i) {
+        out.rows[n] = static_cast<uint32_t>(i - begin);
+        n += filter.test(keys[i]);
+    }
+    out.count = n;
+}
+
+// Semi-join of the selected rows against a key bitmap
+inline void semi_join(const KeyBitmap& filter, const int* keys, Selection& sel) {
+    refine(sel, [&](size_t row) { return filter.test(keys[row]); });
+}
+
+// Join probe: looks up keys[row] of every selected row, keeps the rows that
+// are found and writes their payloads to out[0, sel.count)
+template <typename Index, typename V>
+void probe(const Index& index, const int* keys, Selection& sel, V* out) {
+    uint32_t n = 0;
+    for (uint32_t j = 0; j < sel.count; ++j) {
+        uint32_t r = sel.rows[j];
+        V v = index.get(keys[sel.begin + r]);
+        sel.rows[n] = r;
+        out[n] = v;
+        n += v != Index::kMissing;
+    }
+    sel.count = n;
+}
+
+// Probe for a join on (key, payload): keeps the selected rows whose payload
+// in the index equals expected[j], compacting expected along with them
+template <typename Index, typename V>
+void probe_equal(const Index& index, const int* keys, Selection& sel, V* expected) {
+    uint32_t n = 0;
+    for (uint32_t j = 0; j < sel.count; ++j) {
+        uint32_t r = sel.rows[j];
+        V e = expected[j];
+        sel.rows[n] = r;
+        expected[n] = e;
+        n += index.get(keys[sel.begin + r]) == e;
+    }
+    sel.count = n;
+}
+
+// Adds value(row) into acc under group[j] for every selected row
+template <typename Acc, typename G, typename Value>
+void aggregate(const Selection& sel, const G* group, Value&& value, Acc& acc) {
+    for (uint32_t j = 0; j < sel.count; ++j)
+        acc.add(group[j], value(sel.row(j)));
+}
+
+
+// How a JoinTable stores its keys: direct addressed, radix partitioned
+// hash, or chosen from the key density
+enum class JoinIndexMode {
+    Auto,
+    Dense,
+    Hash
+};
+
+// Auto mode uses a DenseIndex while max key <= kDenseKeyFactor * rows
+constexpr size_t kDenseKeyFactor = 8;
+
+inline bool use_dense_index(JoinIndexMode mode, int max_key, size_t rows) {
+    switch (mode) {
+    case JoinIndexMode::Dense: return true;
+    case JoinIndexMode::Hash:  return false;
+    case JoinIndexMode::Auto:  break;
+    }
+    return static_cast<size_t>(max_key < 0 ? 0 : max_key) <= kDenseKeyFactor * rows + 1024;
+}
+
+// Build side of an equi-join on an int key: key -> payload in a DenseIndex
+// or a PartitionedHashIndex, plus a KeyBitmap of the present keys for
+// semi-join filtering ahead of the probe.
+template <typename V>
+class JoinTable {
+public:
+    static constexpr V kMissing = DenseIndex<V>::kMissing;
+
+    // produce(begin, end, emit) calls emit(key, value) for rows [begin, end)
+    // of the build input; a kMissing value means the row did not qualify.
+    // Dense tables write every emitted slot, so producers can emit every row
+    // branch-free. skip(begin, end) drops whole morsels.
+    template <typename Produce, typename Skip = KeepAll>
+    void build(ThreadPool& pool, size_t rows, int max_key, bool dense, Produce&& produce,
+               Skip&& skip = Skip()) {
+        dense_ = dense;
+        filter_.reset(max_key);
+
+        if (!dense_) {
+            dense_index_ = DenseIndex<V>();
+            hash_index_.build(pool, rows, [&](size_t begin, size_t end, auto&& emit) {
+                if (skip(begin, end)) return;
+                produce(begin, end, [&](int key, V value) {
+                    if (value == kMissing) return;
+                    emit(key, value);
+                    filter_.set(key);
+                });
+            });
+            return;
+        }
+
+        dense_index_.reset(max_key);
+        parallel_for(pool, rows, kRowMorsel, [&](size_t begin, size_t end, int) {
+            if (skip(begin, end)) return;
+            produce(begin, end, [&](int key, V value) { dense_index_.set(key, value); });
+        });
+
+        // Each task owns whole bitmap words, so no atomics are needed
+        parallel_for(pool, filter_.num_words(), kRowMorsel / 32, [&](size_t begin, size_t end, int) {
+            filter_.assign_words(dense_index_, begin, end);
+        });
+    }
+
+    // Calls fn with the underlying index, so per-row probes in fn are not
+    // dispatched on the layout
+    template <typename Fn>
+    decltype(auto) visit(Fn&& fn) const {
+        return dense_ ? fn(dense_index_) : fn(hash_index_);
+    }
+
+    V get(int key) const { return dense_ ? dense_index_.get(key) : hash_index_.get(key); }
+
+    bool dense() const { return dense_; }
+    const DenseIndex<V>& dense_index() const { return dense_index_; }
+    const PartitionedHashIndex<V>& hash_index() const { return hash_index_; }
+    const KeyBitmap& filter() const { return filter_; }
+
+    // Memory held by the index and the key bitmap
+    size_t bytes() const { return dense_index_.bytes() + hash_index_.bytes() + filter_.bytes(); }
+
+private:
+    bool dense_ = true;
+    DenseIndex<V> dense_index_;
+    PartitionedHashIndex<V> hash_index_;
+    KeyBitmap filter_;
+};
+
+
+// Group-by over a small dense group domain: one accumulator per worker
+// (e.g. NationAccumulator, which is cache-line aligned), merged at the end.
+// Acc needs add(group, value) and merge(other).
+template <typename Acc>
+class DenseAggregate {
+public:
+    explicit DenseAggregate(size_t workers) : locals_(workers) {}
+
+    Acc& local(int worker) { return locals_[worker]; }
+    size_t size() const { return locals_.size(); }
+
+    Acc result() const {
+        Acc total;
+        for (const auto& local : locals_)
+            total.merge(local);
+        return total;
+    }
+
+private:
+    std::vector<Acc> locals_;
+};
+
+// Group-by SUM/COUNT over arbitrary keys (e.g. Q3 per orderkey): one hash
+// table per worker, merged at the end
+template <typename Key, typename Value>
+class HashAggregate {
+public:
+    struct Group {
+        Value sum{};
+        int64_t rows = 0;
+    };
+
+    explicit HashAggregate(size_t workers) : locals_(workers) {}
+
+    // Per-worker handle with the same add(group, value) shape as Acc above
+    struct Local {
+        std::unordered_map<Key, Group> groups;
+        void add(const Key& key, Value value) {
+            Group& g = groups[key];
+            g.sum += value;
+            g.rows += 1;
+        }
+    };
+
+    Local& local(int worker) { return locals_[worker]; }
+
+    std::unordered_map<Key, Group> result() const {
+        std::unordered_map<Key, Group> total;
+        for (const auto& local : locals_) {
+            for (const auto& [key, g] : local.groups) {
+                Group& t = total[key];
+                t.sum += g.sum;
+                t.rows += g.rows;
+            }
+        }
+        return total;
+    }
+
+private:
+    std::vector<Local> locals_;
+};
+
+} // namespace ops
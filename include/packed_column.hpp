@@ -0,0 +1,278 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include "thread_pool.hpp"
+
+// Lightweight compressed integer columns, encoded in blocks of kPackBlock
+// rows and decoded one block at a time into a caller buffer that stays in
+// L1/L2 while the scan runs over it.
+constexpr size_t kPackBlock = 2048;
+
+// Bits needed to store every value in [0, range]
+inline unsigned bits_for(uint64_t range) {
+    return range == 0 ? 0 : 64 - __builtin_clzll(range);
+}
+
+// Per-block frame-of-reference bit packing. Each block stores a base and
+// the bit width of its largest offset, so a block of nearby keys costs only
+// the bits of its own spread.
+//
+// Delta mode packs the differences between neighbouring rows instead, FOR
+// against the block's smallest step: a sorted key column such as
+// l_orderkey then needs a handful of bits per row.
+class PackedColumn {
+public:
+    enum class Encoding : uint8_t { FrameOfReference, Delta };
+
+    // Encodes values[0, n); blocks are packed in parallel on the pool
+    template <typename T>
+    void encode(const T* values, size_t n, Encoding encoding, ThreadPool& pool) {
+        clear();
+        append(values, n, encoding, pool);
+    }
+
+    // Encodes values[0, n) after the rows already held, which must be a
+    // whole number of blocks; the result is the same as one encode of all
+    // the rows
+    template <typename T>
+    void append(const T* values, size_t n, Encoding encoding, ThreadPool& pool) {
+        if (rows_ % kPackBlock != 0)
+            throw std::logic_error("PackedColumn::append after a partial block");
+        const size_t first = blocks_.size();
+        encoding_ = encoding;
+        rows_ += n;
+        blocks_.resize((rows_ + kPackBlock - 1) / kPackBlock);
+
+        // Pass 1: base, step and width of every new block
+        pool.run(blocks_.size() - first, [&](size_t t, int) {
+            const size_t b = first + t;
+            const T* v = values + t * kPackBlock;
+            size_t count = block_rows(b);
+            Block& block = blocks_[b];
+            block.base = static_cast<int64_t>(v[0]);
+            if (encoding_ == Encoding::Delta) {
+                int64_t lo = 0, hi = 0;
+                for (size_t i = 1; i < count; ++i) {
+                    int64_t step = static_cast<int64_t>(v[i]) - static_cast<int64_t>(v[i - 1]);
+                    lo = i == 1 ? step : std::min(lo, step);
+                    hi = i == 1 ? step : std::max(hi, step);
+                }
+                block.step = lo;
+                block.width = static_cast<uint8_t>(bits_for(static_cast<uint64_t>(hi - lo)));
+            } else {
+                int64_t lo = block.base, hi = block.base;
+                for (size_t i = 1; i < count; ++i) {
+                    lo = std::min(lo, static_cast<int64_t>(v[i]));
+                    hi = std::max(hi, static_cast<int64_t>(v[i]));
+                }
+                block.base = lo;
+                block.width = static_cast<uint8_t>(bits_for(static_cast<uint64_t>(hi - lo)));
+            }
+        });
+
+        // Blocks start on a word boundary so pass 2 never shares a word
+        // between two tasks. New blocks start at the old spare word
+        size_t words = words_.empty() ? 0 : words_.size() - 1;
+        for (size_t b = first; b < blocks_.size(); ++b) {
+            blocks_[b].word = words;
+            words += (block_rows(b) * blocks_[b].width + 63) / 64;
+        }
+        words_.resize(words + 1, 0);   // one spare word for the straddling read
+
+        // Pass 2: pack the offsets
+        pool.run(blocks_.size() - first, [&](size_t t, int) {
+            const size_t b = first + t;
+            const T* v = values + t * kPackBlock;
+            const Block& block = blocks_[b];
+            if (block.width == 0) return;
+            uint64_t* out = words_.data() + block.word;
+            for (size_t i = 0; i < block_rows(b); ++i) {
+                uint64_t offset;
+                if (encoding_ == Encoding::Delta)
+                    offset = i == 0 ? 0 : static_cast<uint64_t>(static_cast<int64_t>(v[i])
+                                          - static_cast<int64_t>(v[i - 1]) - block.step);
+                else
+                    offset = static_cast<uint64_t>(static_cast<int64_t>(v[i]) - block.base);
+                size_t bit = i * block.width;
+                out[bit >> 6] |= offset << (bit & 63);
+                if ((bit & 63) + block.width > 64)
+                    out[(bit >> 6) + 1] |= offset >> (64 - (bit & 63));
+            }
+        });
+    }
+
+    // Writes the block_rows(b) values of block b to out
+    template <typename T>
+    void decode_block(size_t b, T* out) const {
+        const Block& block = blocks_[b];
+        size_t count = block_rows(b);
+        const unsigned width = block.width;
+        if (width == 0) {
+            if (encoding_ == Encoding::Delta)
+                for (size_t i = 0; i < count; ++i)
+                    out[i] = static_cast<T>(block.base + block.step * static_cast<int64_t>(i));
+            else
+                std::fill(out, out + count, static_cast<T>(block.base));
+            return;
+        }
+
+        const uint64_t* in = words_.data() + block.word;
+        const uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+        if (width > kFastWidth) {
+            int64_t value = block.base;
+            for (size_t i = 0; i < count; ++i) {
+                int64_t offset = static_cast<int64_t>(extract(in, i * width, width, mask));
+                value = encoding_ == Encoding::Delta ? (i == 0 ? value : value + block.step + offset)
+                                                     : block.base + offset;
+                out[i] = static_cast<T>(value);
+            }
+            return;
+        }
+
+        // Common case: every offset lies inside one unaligned 8-byte load.
+        // Dispatch on the width so the unpack loop sees it as a constant
+        unpack_table<T>(std::make_index_sequence<kFastWidth + 1>())[width](
+            reinterpret_cast<const unsigned char*>(in), count, block.base, block.step,
+            encoding_ == Encoding::Delta, out);
+    }
+
+    void clear() {
+        rows_ = 0;
+        blocks_.clear();
+        words_.clear();
+    }
+
+    size_t size() const { return rows_; }
+    size_t num_blocks() const { return blocks_.size(); }
+    size_t block_rows(size_t b) const {
+        return b + 1 < blocks_.size() ? kPackBlock : rows_ - b * kPackBlock;
+    }
+    size_t bytes() const {
+        return words_.size() * sizeof(uint64_t) + blocks_.size() * sizeof(Block);
+    }
+
+private:
+    struct Block {
+        int64_t base = 0;   // FOR: block minimum; delta: first value
+        int64_t step = 0;   // delta only: smallest step in the block
+        size_t word = 0;    // first word of the block's packed bits
+        uint8_t width = 0;  // bits per packed offset
+    };
+
+    // Widths whose offsets always fit one 8-byte load at their byte address
+    static constexpr unsigned kFastWidth = 56;
+
+    static uint64_t load_bits(const unsigned char* bytes, size_t bit) {
+        uint64_t word;
+        std::memcpy(&word, bytes + (bit >> 3), sizeof(word));
+        return word >> (bit & 7);
+    }
+
+    template <typename T>
+    using Unpacker = void (*)(const unsigned char*, size_t, int64_t, int64_t, bool, T*);
+
+    template <unsigned W, typename T>
+    static void unpack(const unsigned char* __restrict bytes, size_t count, int64_t base, int64_t step,
+                       bool delta, T* __restrict out) {
+        constexpr uint64_t mask = (uint64_t(1) << W) - 1;
+        if (delta) {
+            int64_t value = base;
+            out[0] = static_cast<T>(value);
+            for (size_t i = 1; i < count; ++i) {
+                value += step + static_cast<int64_t>(load_bits(bytes, i * W) & mask);
+                out[i] = static_cast<T>(value);
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = static_cast<T>(base + static_cast<int64_t>(load_bits(bytes, i * W) & mask));
+        }
+    }
+
+    template <typename T, size_t... W>
+    static const Unpacker<T>* unpack_table(std::index_sequence<W...>) {
+        static const Unpacker<T> table[] = { &unpack<static_cast<unsigned>(W), T>... };
+        return table;
+    }
+
+    static uint64_t extract(const uint64_t* in, size_t bit, unsigned width, uint64_t mask) {
+        uint64_t lo = in[bit >> 6] >> (bit & 63);
+        if ((bit & 63) + width > 64)
+            lo |= in[(bit >> 6) + 1] << (64 - (bit & 63));
+        return lo & mask;
+    }
+
+    Encoding encoding_ = Encoding::FrameOfReference;
+    size_t rows_ = 0;
+    std::vector<Block> blocks_;
+    std::vector<uint64_t> words_;
+};
+
+// Dictionary encoding for low-cardinality columns (l_discount has 11
+// values): distinct values plus bit-packed codes into them. Codes are
+// handed out in order of first appearance, so a value new to a later
+// append does not renumber the codes already packed.
+template <typename T>
+class DictionaryColumn {
+public:
+    static constexpr size_t kMaxEntries = 256;
+
+    // False if the column has more than kMaxEntries distinct values
+    bool encode(const T* values, size_t n, ThreadPool& pool) {
+        clear();
+        return append(values, n, pool);
+    }
+
+    // Encodes values[0, n) after the rows already held, which must be a
+    // whole number of blocks. False if the column would then have more than
+    // kMaxEntries distinct values
+    bool append(const T* values, size_t n, ThreadPool& pool) {
+        for (size_t i = 0; i < n; ++i) {
+            auto it = std::lower_bound(sorted_.begin(), sorted_.end(), values[i], less_value);
+            if (it != sorted_.end() && it->first == values[i])
+                continue;
+            if (dictionary_.size() == kMaxEntries)
+                return false;
+            sorted_.insert(it, {values[i], static_cast<uint8_t>(dictionary_.size())});
+            dictionary_.push_back(values[i]);
+        }
+
+        std::vector<uint8_t> codes(n);
+        parallel_for(pool, n, kRowMorsel, [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; ++i)
+                codes[i] = std::lower_bound(sorted_.begin(), sorted_.end(), values[i], less_value)->second;
+        });
+        codes_.append(codes.data(), n, PackedColumn::Encoding::FrameOfReference, pool);
+        return true;
+    }
+
+    // Codes are unpacked into out and then replaced by their values in place
+    void decode_block(size_t b, T* out) const {
+        codes_.decode_block(b, out);
+        const T* dictionary = dictionary_.data();
+        for (size_t i = 0; i < codes_.block_rows(b); ++i)
+            out[i] = dictionary[static_cast<size_t>(out[i])];
+    }
+
+    void clear() {
+        dictionary_.clear();
+        sorted_.clear();
+        codes_.clear();
+    }
+
+    size_t size() const { return codes_.size(); }
+    size_t bytes() const { return codes_.bytes() + dictionary_.size() * sizeof(T); }
+
+private:
+    static bool less_value(const std::pair<T, uint8_t>& entry, const T& value) {
+        return entry.first < value;
+    }
+
+    std::vector<T> dictionary_;                  // code -> value
+    std::vector<std::pair<T, uint8_t>> sorted_;  // (value, code) by value, for encoding
+    PackedColumn codes_;
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <climits>
+#include <vector>
+#include "thread_pool.hpp"
+
+// Key -> value hash index for key domains too sparse for a DenseIndex,
+// built in parallel with no serial merge:
+//   1. scatter: every morsel appends its (key, value) pairs to its worker's
+//      buffer for the key's radix partition (top bits of the hash);
+//   2. build: one task per partition gathers that partition's pairs from all
+//      workers into its own open-addressing table.
+// Probes route to a partition by the same bits, so each partition table is
+// small, private to its builder and cache friendly.
+template <typename V>
+class PartitionedHashIndex {
+public:
+    static constexpr V kMissing = static_cast<V>(-1);
+    static constexpr int kPartitionBits = 6;
+    static constexpr int kPartitions = 1 << kPartitionBits;
+
+    // produce(begin, end, emit) must call emit(key, value) for every pair
+    // contributed by rows [begin, end). Keys are expected to be unique.
+    template <typename Produce>
+    void build(ThreadPool& pool, size_t rows, Produce&& produce) {
+        std::vector<std::vector<std::vector<Entry>>> scatter(
+            pool.size(), std::vector<std::vector<Entry>>(kPartitions));
+
+        parallel_for(pool, rows, kRowMorsel, [&](size_t begin, size_t end, int worker) {
+            auto& buffers = scatter[worker];
+            produce(begin, end, [&](int key, V value) {
+                buffers[partition_of(hash(key))].push_back(Entry{key, value});
+            });
+        });
+
+        parts_.assign(kPartitions, Partition());
+        pool.run(kPartitions, [&](size_t p, int) {
+            size_t count = 0;
+            for (const auto& buffers : scatter)
+                count += buffers[p].size();
+
+            Partition& part = parts_[p];
+            size_t capacity = 16;
+            while (capacity < count * 2) capacity <<= 1;
+            part.mask = static_cast<uint32_t>(capacity - 1);
+            part.keys.assign(capacity, kEmptyKey);
+            part.values.assign(capacity, kMissing);
+
+            for (const auto& buffers : scatter) {
+                for (const Entry& e : buffers[p]) {
+                    uint32_t slot = hash(e.key) & part.mask;
+                    while (part.keys[slot] != kEmptyKey && part.keys[slot] != e.key)
+                        slot = (slot + 1) & part.mask;
+                    part.keys[slot] = e.key;
+                    part.values[slot] = e.value;
+                }
+            }
+            part.size = count;
+        });
+    }
+
+    V get(int key) const {
+        const uint32_t h = hash(key);
+        const Partition& part = parts_[partition_of(h)];
+        uint32_t slot = h & part.mask;
+        for (;;) {
+            int k = part.keys[slot];
+            if (k == key) return part.values[slot];
+            if (k == kEmptyKey) return kMissing;
+            slot = (slot + 1) & part.mask;
+        }
+    }
+
+    bool contains(int key) const {
+        return get(key) != kMissing;
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        for (const auto& part : parts_) n += part.size;
+        return n;
+    }
+
+    size_t bytes() const {
+        size_t n = 0;
+        for (const auto& part : parts_) n += part.keys.size() * sizeof(int) + part.values.size() * sizeof(V);
+        return n;
+    }
+
+private:
+    static constexpr int kEmptyKey = INT_MIN;
+
+    struct Entry {
+        int key;
+        V value;
+    };
+
+    struct Partition {
+        std::vector<int> keys;
+        std::vector<V> values;
+        uint32_t mask = 0;
+        size_t size = 0;
+    };
+
+    static uint32_t hash(int key) {
+        return static_cast<uint32_t>(key) * 0x9E3779B1u;
+    }
+
+    static uint32_t partition_of(uint32_t h) {
+        return h >> (32 - kPartitionBits);
+    }
+
+    // A default-built index has one empty partition per radix so probes
+    // before build() simply miss
+    std::vector<Partition> parts_ = std::vector<Partition>(kPartitions, empty_partition());
+
+    static Partition empty_partition() {
+        Partition part;
+        part.keys.assign(1, kEmptyKey);
+        part.values.assign(1, kMissing);
+        return part;
+    }
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "fixed_point.hpp"
+#include "nation_accumulator.hpp"
+
+// Q5 lineitem probe-and-aggregate kernels over raw column pointers, for
+// builds whose order and supplier indexes are both dense. The portable
+// path is probe_lineitem in query5.cpp; these are the vectorized variants
+// selected at runtime.
+
+struct LineItemColumns {
+    const int* orderkey;
+    const int* suppkey;
+    const Cents* extendedprice;
+    const Cents* discount;
+};
+
+struct DenseProbeTables {
+    const int8_t* order_nation;   // DenseIndex data, kTailPadding slots past the end
+    size_t order_slots;
+    const int8_t* supp_nation;
+    size_t supp_slots;
+    NationSet nations;            // nations that can match (the region's)
+};
+
+// Signature shared by all kernels; rows [start, end) are added to acc
+using ProbeKernel = void (*)(const LineItemColumns& cols, size_t start, size_t end,
+                             const DenseProbeTables& tables, NationAccumulator& acc);
+
+#if defined(__x86_64__) || defined(__i386__)
+// AVX2: gathers both nation indexes 8 rows at a time, compares them, and
+// adds the masked revenues into per-nation vector lanes
+void probe_dense_avx2(const LineItemColumns& cols, size_t start, size_t end,
+                      const DenseProbeTables& tables, NationAccumulator& acc);
+#endif
+
+// Best kernel the running CPU supports, or nullptr for the scalar path
+ProbeKernel select_probe_kernel();
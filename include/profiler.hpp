@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "thread_pool.hpp"
+
+// Phase-level instrumentation behind --report. Every phase of the load and
+// of Q5 is recorded with its wall time, rows in and out, bytes of column
+// data it touched and how long each pool worker was busy during it. With
+// --perf on, cycles, instructions and LLC misses summed over the pool's
+// threads are added from perf_event_open counters. Everything is a no-op
+// until enable_profiling() is called.
+
+// Records with the same name are merged: calls counts them, wall_ms and
+// the other totals are summed and max_wall_ms keeps the slowest call.
+struct PhaseRecord {
+    std::string name;
+    uint64_t calls = 1;
+    double wall_ms = 0.0;
+    double max_wall_ms = 0.0;
+    uint64_t rows_in = 0;
+    uint64_t rows_out = 0;
+    uint64_t bytes = 0;
+    std::vector<double> thread_busy_ms;   // per pool worker, empty if not measured
+    bool has_counters = false;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t llc_misses = 0;
+};
+
+void enable_profiling(bool hardware_counters);
+bool profiling_enabled();
+
+// Adds a phase measured elsewhere (e.g. a table's share of the load wave)
+void record_phase(const PhaseRecord& record);
+
+// Times the enclosing scope as one phase; worker busy times and counters
+// are taken from the pool the phase runs on
+class PhaseTimer {
+public:
+    PhaseTimer(const char* name, ThreadPool& pool);
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    void rows(uint64_t in, uint64_t out) {
+        record_.rows_in = in;
+        record_.rows_out = out;
+    }
+    void bytes(uint64_t b) { record_.bytes = b; }
+
+private:
+    bool active_;
+    ThreadPool& pool_;
+    PhaseRecord record_;
+    uint64_t start_ns_ = 0;
+    std::vector<uint64_t> start_busy_;
+    uint64_t start_counters_[3] = {};
+};
+
+// Phases recorded so far, in the order each name first finished
+std::vector<PhaseRecord> recorded_phases();
+void clear_recorded_phases();
+
+// Writes every recorded phase as JSON; false if the file cannot be written
+bool write_profile_report(const std::string& path);
@@ -4,13 +4,43 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstdint>
 #include "tables_soa.hpp"
+#include "dense_index.hpp"
+#include "key_bitmap.hpp"
+#include "partitioned_hash_index.hpp"
+#include "nation_accumulator.hpp"
+#include "operators.hpp"
+#include "query_cache.hpp"
+#include <memory>
+#include <unordered_map>
 
 #pragma once
 #include <string>
 
+// How .tbl files are read: std::getline + istringstream per line, or an
+// mmap of the whole file parsed in place
+enum class LoadMode {
+    Stream,
+    Mmap
+};
+
+// Index used for the orderkey → nation join (see operators.hpp)
+using JoinIndexMode = ops::JoinIndexMode;
+
 struct Config {
     int num_threads = 1;
+    LoadMode load_mode = LoadMode::Mmap;
+    bool use_cache = false;   // read/write <table>.tbl.colcache binary column files
+    bool stream_lineitem = false;   // probe lineitem.tbl morsels as they are parsed
+    JoinIndexMode join_index = JoinIndexMode::Auto;
+    bool simd_probe = true;   // use a vectorized lineitem kernel when the CPU has one
+    bool compress_lineitem = false;   // scan a bit-packed copy of lineitem instead of the raw columns
+    std::string serve;   // server mode endpoint: "stdin" or a Unix socket path, empty for one query
+    std::string batch_file;   // batch mode: file of parameter sets answered in one lineitem scan
+    std::string report_path;   // per-phase JSON profile written here at exit, empty for none
+    bool perf_counters = false;   // add perf_event_open counters to the profile
+    bool numa = false;   // pin workers and place scanned columns on their node
     std::string r_name;
     std::string start_date;
     std::string end_date;
@@ -26,6 +56,23 @@ class tables; // Forward declaration
 // Function to parse command line arguments
 bool parseArgs(int argc, char* argv[], std::string& r_name, std::string& start_date, std::string& end_date, int& num_threads, std::string& table_path, std::string& result_path);
 
+// One table of a concurrent load; bytes and seconds (first morsel start to
+// last morsel end) are filled in by load_tables_concurrently
+struct LoadJob {
+    std::string name;
+    std::string file_path;
+    tables* output = nullptr;
+    size_t bytes = 0;
+    double seconds = 0.0;
+};
+
+// Function to load several .tbl files as one pool of byte-range tasks
+bool load_tables_concurrently(std::vector<LoadJob>& jobs, int num_threads, LoadMode mode);
+
+// Function to load one .tbl file into a table using 1 MB byte-range chunks
+void load_data_multithreaded(const std::string& file_path, tables& output, int num_threads,
+                             LoadMode mode = LoadMode::Mmap);
+
 // Function to read TPCH data from the specified paths
 // bool readTPCHData(const std::string& table_path, tables& customer_data, tables& orders_data, tables& lineitem_data, tables& supplier_data, tables& nation_data, tables& region_data);
 bool readTPCHData(const std::string& table_path, CustomerSOA& customer_data, OrdersSOA& orders_data,
@@ -35,7 +82,102 @@ bool readTPCHData(const std::string& table_path, CustomerSOA& customer_data, Ord
 bool executeQuery5(const std::string& r_name, const std::string& start_date, const std::string& end_date, int num_threads,
                    const CustomerSOA& customer_data, const OrdersSOA& orders_data, const LineItemSOA& lineitem_data,
                    const SupplierSOA& supplier_data, const NationSOA& nation_data, const RegionSOA& region_data,
-                   std::map<std::string, double>& results);
+                   std::map<std::string, double>& results, Q5Cache* cache = nullptr,
+                   std::string* error = nullptr);
+
+// Function to execute TPCH Query 5 over a compressed lineitem table
+bool executeQuery5(const std::string& r_name, const std::string& start_date, const std::string& end_date, int num_threads,
+                   const CustomerSOA& customer_data, const OrdersSOA& orders_data, const PackedLineItemSOA& lineitem_data,
+                   const SupplierSOA& supplier_data, const NationSOA& nation_data, const RegionSOA& region_data,
+                   std::map<std::string, double>& results, Q5Cache* cache = nullptr,
+                   std::string* error = nullptr);
+
+// Q5 state built from region, nation, supplier, customer and orders; the
+// lineitem probe only reads it
+struct Q5BuildSide {
+    std::unordered_map<int, std::string> nationkey_to_name;   // nations of the region
+    NationSet region_nations = 0;
+    std::shared_ptr<const ops::JoinTable<int8_t>> suppliers;   // suppkey → nation, region's suppliers only
+    std::shared_ptr<const Q5OrdersSide> orders;                 // orderkey → nation, qualifying orders only
+};
+
+// Function to build the Q5 join state from everything except lineitem,
+// reusing and filling the pieces held by cache when one is given
+bool buildQ5BuildSide(const std::string& r_name, const std::string& start_date, const std::string& end_date,
+                      int num_threads, const CustomerSOA& customer_data, const OrdersSOA& orders_data,
+                      const SupplierSOA& supplier_data, const NationSOA& nation_data,
+                      const RegionSOA& region_data, Q5BuildSide& build, Q5Cache* cache = nullptr,
+                      std::string* error = nullptr);
+
+// Function to probe lineitem rows [start, end) against a build side and aggregate into acc
+void probe_lineitem(size_t start, size_t end, const LineItemSOA& lineitem, const Q5BuildSide& build,
+                    NationAccumulator& acc);
+
+// Decoded block of compressed lineitem, reused across probes by one thread
+struct PackedProbeBuffer {
+    std::unique_ptr<PackedLineItemSOA::Block> block = std::make_unique<PackedLineItemSOA::Block>();
+    size_t index = SIZE_MAX;   // block held, SIZE_MAX if none
+};
+
+// Same for compressed lineitem, decoding blocks into buffer as needed
+void probe_lineitem(size_t start, size_t end, const PackedLineItemSOA& lineitem, const Q5BuildSide& build,
+                    PackedProbeBuffer& buffer, NationAccumulator& acc);
+
+// Function to execute TPCH Query 5 while parsing lineitem.tbl in morsels instead of loading it
+bool executeQuery5Streaming(const std::string& r_name, const std::string& start_date, const std::string& end_date,
+                            int num_threads, const std::string& lineitem_path,
+                            const CustomerSOA& customer_data, const OrdersSOA& orders_data,
+                            const SupplierSOA& supplier_data, const NationSOA& nation_data,
+                            const RegionSOA& region_data, std::map<std::string, double>& results,
+                            Q5Cache* cache = nullptr, std::string* error = nullptr);
+
+// All six tables as loaded by one process. lineitem is held as raw columns,
+// as the compressed copy (--compress on), or left on disk (--stream on).
+struct TPCHData {
+    std::string table_path;
+    CustomerSOA customer;
+    OrdersSOA orders;
+    LineItemSOA lineitem;
+    PackedLineItemSOA packed_lineitem;
+    bool lineitem_packed = false;
+    SupplierSOA supplier;
+    NationSOA nation;
+    RegionSOA region;
+    Q5Cache cache;   // earlier queries on these tables
+};
+
+// Function to load (or reload) every table under table_path as g_config asks.
+// data is replaced, and its cache dropped, only if the whole load succeeds
+bool loadTPCHData(const std::string& table_path, TPCHData& data);
+
+// Function to run Q5 on loaded data with whichever lineitem scan it was loaded
+// for; repeated parameters are answered from data.cache. On failure error,
+// if given, says why
+bool runQuery5(TPCHData& data, const std::string& r_name, const std::string& start_date,
+               const std::string& end_date, int num_threads, std::map<std::string, double>& results,
+               std::string* error = nullptr);
+
+// One Q5 parameter set of a batch
+struct Q5Params {
+    std::string r_name;
+    std::string start_date;
+    std::string end_date;
+};
+
+// Function to read a batch file: one "<r_name> <start_date> <end_date>" per line
+bool readBatchFile(const std::string& path, std::vector<Q5Params>& params);
+
+// Function to answer every parameter set with one lineitem scan per 56 queries;
+// results[i] belongs to params[i]
+bool executeQuery5Batch(const TPCHData& data, const std::vector<Q5Params>& params, int num_threads,
+                        std::vector<std::map<std::string, double>>& results);
+
+// Function to write batch results to <result_path>\query5_batch_result.txt
+bool outputBatchResults(const std::string& result_path, const std::vector<Q5Params>& params,
+                        const std::vector<std::map<std::string, double>>& results);
+
+// Orders (n_name, revenue) pairs by revenue, largest first
+bool comparator(const std::pair<std::string, double>& a, const std::pair<std::string, double>& b);
 
 // Function to output results to the specified path
 bool outputResults(const std::string& result_path, const std::map<std::string, double>& results);
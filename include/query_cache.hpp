@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include "operators.hpp"
+
+// Approximate memory held by each kind of cached value; overloads for types
+// declared further down are found by argument-dependent lookup
+inline size_t cache_bytes(const std::map<std::string, double>& results) {
+    size_t n = sizeof(results);
+    for (const auto& [name, revenue] : results)
+        n += sizeof(name) + name.size() + sizeof(revenue) + 4 * sizeof(void*);   // node overhead
+    return n;
+}
+
+template <typename V>
+size_t cache_bytes(const ops::JoinTable<V>& table) {
+    return table.bytes();
+}
+
+// String-keyed cache of immutable values, bounded by both entry count and
+// the bytes its values hold (cache_bytes(value)). Entries are shared, so a
+// build side can keep using a value after it has been evicted; the oldest
+// entries go first once either limit would be exceeded, and a value larger
+// than the whole byte limit is returned without being cached.
+template <typename V>
+class KeyedCache {
+public:
+    KeyedCache(size_t max_entries, size_t max_bytes) : max_entries_(max_entries), max_bytes_(max_bytes) {}
+
+    std::shared_ptr<const V> find(const std::string& key) const {
+        auto it = entries_.find(key);
+        return it == entries_.end() ? nullptr : it->second.value;
+    }
+
+    // Returns the cached value for key, building it with make() on a miss
+    template <typename Make>
+    std::shared_ptr<const V> get(const std::string& key, Make&& make) {
+        if (auto hit = find(key)) {
+            ++hits_;
+            return hit;
+        }
+        ++misses_;
+        std::shared_ptr<const V> value = make();
+        if (!value) return value;
+
+        const size_t size = cache_bytes(*value);
+        if (size > max_bytes_ || max_entries_ == 0) return value;
+        while (!entries_.empty() && (entries_.size() >= max_entries_ || bytes_ + size > max_bytes_)) {
+            auto oldest = entries_.begin();
+            for (auto it = entries_.begin(); it != entries_.end(); ++it)
+                if (it->second.stamp < oldest->second.stamp) oldest = it;
+            bytes_ -= oldest->second.bytes;
+            entries_.erase(oldest);
+        }
+        entries_[key] = Entry{value, size, next_stamp_++};
+        bytes_ += size;
+        return value;
+    }
+
+    void clear() {
+        entries_.clear();
+        bytes_ = 0;
+    }
+
+    size_t bytes() const { return bytes_; }
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    struct Entry {
+        std::shared_ptr<const V> value;
+        size_t bytes;
+        uint64_t stamp;
+    };
+
+    std::map<std::string, Entry> entries_;
+    size_t max_entries_;
+    size_t max_bytes_;
+    size_t bytes_ = 0;
+    uint64_t next_stamp_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+// orderkey → customer nation for one (region, date range), with the zone
+// map statistics of the scan that built it
+struct Q5OrdersSide {
+    ops::JoinTable<int8_t> table;
+    size_t rows = 0;      // orders scanned
+    size_t skipped = 0;   // of which skipped by the o_orderdate zone map
+};
+
+inline size_t cache_bytes(const Q5OrdersSide& side) {
+    return side.table.bytes();
+}
+
+// Q5 results and build-side pieces from earlier queries on the same loaded
+// tables. Suppliers and customers depend only on the region, so a query
+// that changes just the dates rebuilds only the orders side. Owned by the
+// loaded data and dropped with it on reload. Not thread safe: the server
+// answers one request at a time.
+//
+// The orders side is a dense orderkey index plus a bitmap, about 0.6 GB at
+// SF100, so it gets a byte budget of its own rather than an entry count
+// that could add up to gigabytes in a long-running server.
+struct Q5Cache {
+    static constexpr size_t kMB = size_t(1) << 20;
+
+    KeyedCache<std::map<std::string, double>> results{256, 16 * kMB};     // "region|start|end"
+    KeyedCache<ops::JoinTable<int8_t>> suppliers{16, 256 * kMB};          // "region"
+    KeyedCache<ops::JoinTable<int8_t>> customers{16, 256 * kMB};          // "region"
+    KeyedCache<Q5OrdersSide> orders{16, 1024 * kMB};                      // "region|start_day|end_day"
+
+    void clear() {
+        results.clear();
+        suppliers.clear();
+        customers.clear();
+        orders.clear();
+    }
+};
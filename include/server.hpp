@@ -0,0 +1,26 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include "query5.hpp"
+
+// Server mode (--serve): the tables stay loaded and Q5 requests are answered
+// one line at a time, from stdin or from clients of a Unix socket.
+//
+// Requests:
+//   Q5 <r_name> <start_date> <end_date>   r_name may contain spaces
+//   RELOAD                                 reload every table from disk; on failure
+//                                          the previous tables stay loaded
+//   PING
+//   QUIT                                   end this session
+//   SHUTDOWN                               stop the server
+//
+// Replies:
+//   OK <rows> <latency_ms>                 followed by <rows> lines of n_name|revenue,
+//                                          sorted by revenue descending
+//   ERR <message>
+//   PONG
+bool run_server(const std::string& endpoint, TPCHData& data, std::ostream& stdin_replies);
+
+// Handles one request line and writes the reply. Returns false once the
+// session should end; shutdown is set if the whole server should stop.
+bool handle_request(const std::string& line, TPCHData& data, std::ostream& reply, bool& shutdown);
@@ -3,6 +3,13 @@
 #include<memory>
 #include <string>
 #include <sstream>
+#include <iterator>
+#include "tbl_parser.hpp"
+#include "column_cache.hpp"
+#include "fixed_point.hpp"
+#include "packed_column.hpp"
+#include "zone_map.hpp"
+#include "column_storage.hpp"
 
 class tables {
 public:
@@ -11,22 +18,46 @@ public:
     // Parse one line into columns
     virtual void insert_line(const std::string& line) = 0;
 
+    // Parse the row starting at p in place into slot `row` (the columns must
+    // already be sized with resize); returns the start of the next row
+    virtual const char* insert_row(const char* p, const char* end, size_t row) = 0;
+
+    // Size every column to exactly `rows` rows
+    virtual void resize(size_t rows) = 0;
+
+    // Room for `rows` rows without reallocating
+    virtual void reserve(size_t rows) = 0;
+
+    // Indices of the .tbl columns this table keeps; all others are skipped
+    virtual std::vector<int> columns() const = 0;
+
+    // Write / read every column, in declaration order, for the binary cache
+    virtual void save_columns(ColumnWriter& out) const = 0;
+    virtual bool load_columns(ColumnReader& in) = 0;
+
     // Create an empty object of the same derived type
     virtual std::unique_ptr<tables> create_empty() const = 0;
 
-    // Merge another instance's data into this one
+    // Merge another instance's data into this one; other must come from
+    // this table's create_empty()
     virtual void merge_from(const tables& other) = 0;
 
     virtual int size() const = 0;
 
+    // Drop all rows
+    virtual void clear() = 0;
+
 };
 
 
 
 class CustomerSOA : public tables {
 public:
-    std::vector<int> c_custkey;
-    std::vector<int> c_nationkey;
+    Column<int> c_custkey;
+    Column<int> c_nationkey;
+
+    // c_custkey, c_nationkey
+    static constexpr int kColumns[] = {0, 3};
 
     void insert_line(const std::string& line) override {
         std::istringstream ss(line);
@@ -46,12 +77,43 @@ public:
         c_nationkey.push_back(nationkey);
     }
 
+    const char* insert_row(const char* p, const char* end, size_t row) override {
+        tbl::FieldCursor f(p, end);
+        c_custkey[row] = f.int_at(kColumns[0]);
+        c_nationkey[row] = f.int_at(kColumns[1]);
+        return f.next_line();
+    }
+
+    void resize(size_t rows) override {
+        c_custkey.resize(rows);
+        c_nationkey.resize(rows);
+    }
+
+    void reserve(size_t rows) override {
+        c_custkey.reserve(rows);
+        c_nationkey.reserve(rows);
+    }
+
+    std::vector<int> columns() const override {
+        return std::vector<int>(std::begin(kColumns), std::end(kColumns));
+    }
+
+    void save_columns(ColumnWriter& out) const override {
+        out.write(c_custkey);
+        out.write(c_nationkey);
+    }
+
+    bool load_columns(ColumnReader& in) override {
+        return in.read(c_custkey)
+            && in.read(c_nationkey);
+    }
+
     std::unique_ptr<tables> create_empty() const override {
         return std::make_unique<CustomerSOA>();
     }
 
     void merge_from(const tables& other_base) override {
-        const auto& other = dynamic_cast<const CustomerSOA&>(other_base);
+        const auto& other = static_cast<const CustomerSOA&>(other_base);
 
         c_custkey.insert(c_custkey.end(),
                          other.c_custkey.begin(),
@@ -65,14 +127,23 @@ public:
     int size() const {
         return c_custkey.size();
     }
+
+    void clear() override {
+        c_custkey.clear();
+        c_nationkey.clear();
+    }
 };
 
 
 class OrdersSOA : public tables {
 public:
-    std::vector<int> o_orderkey;
-    std::vector<int> o_custkey;
-    std::vector<std::string> o_orderdate;
+    Column<int> o_orderkey;
+    Column<int> o_custkey;
+    Column<int> o_orderdate;   // days since 1970-01-01
+    ZoneMap o_orderdate_zones;      // built once loading is done
+
+    // o_orderkey, o_custkey, o_orderdate
+    static constexpr int kColumns[] = {0, 1, 4};
 
     void insert_line(const std::string& line) override {
         std::istringstream ss(line);    
@@ -84,19 +155,57 @@ public:
                 o_orderkey.push_back(std::stoi(value));
             else if (index == 1)
                 o_custkey.push_back(std::stoi(value));
-            else if (index == 4)
-                o_orderdate.push_back(value);
+            else if (index == 4) {
+                const char* p = value.c_str();
+                o_orderdate.push_back(tbl::parse_date(p, p + value.size()));
+            }
 
             index++;
         }
     }
 
+    const char* insert_row(const char* p, const char* end, size_t row) override {
+        tbl::FieldCursor f(p, end);
+        o_orderkey[row] = f.int_at(kColumns[0]);
+        o_custkey[row] = f.int_at(kColumns[1]);
+        o_orderdate[row] = f.date_at(kColumns[2]);
+        return f.next_line();
+    }
+
+    void resize(size_t rows) override {
+        o_orderkey.resize(rows);
+        o_custkey.resize(rows);
+        o_orderdate.resize(rows);
+    }
+
+    void reserve(size_t rows) override {
+        o_orderkey.reserve(rows);
+        o_custkey.reserve(rows);
+        o_orderdate.reserve(rows);
+    }
+
+    std::vector<int> columns() const override {
+        return std::vector<int>(std::begin(kColumns), std::end(kColumns));
+    }
+
+    void save_columns(ColumnWriter& out) const override {
+        out.write(o_orderkey);
+        out.write(o_custkey);
+        out.write(o_orderdate);
+    }
+
+    bool load_columns(ColumnReader& in) override {
+        return in.read(o_orderkey)
+            && in.read(o_custkey)
+            && in.read(o_orderdate);
+    }
+
     std::unique_ptr<tables> create_empty() const override {
         return std::make_unique<OrdersSOA>();
     }
 
     void merge_from(const tables& other_base) override {
-        const auto& other = dynamic_cast<const OrdersSOA&>(other_base);
+        const auto& other = static_cast<const OrdersSOA&>(other_base);
         o_orderkey.insert(o_orderkey.end(),
                          other.o_orderkey.begin(), other.o_orderkey.end());
         o_custkey.insert(o_custkey.end(),
@@ -108,13 +217,23 @@ public:
     int size() const {
         return o_orderkey.size();
     }
+
+    void clear() override {
+        o_orderkey.clear();
+        o_custkey.clear();
+        o_orderdate.clear();
+        o_orderdate_zones.clear();
+    }
 };
 
 
 class SupplierSOA : public tables {
 public:
-    std::vector<int> s_suppkey;
-    std::vector<int> s_nationkey;
+    Column<int> s_suppkey;
+    Column<int> s_nationkey;
+
+    // s_suppkey, s_nationkey
+    static constexpr int kColumns[] = {0, 3};
 
     void insert_line(const std::string& line) override {
         std::istringstream ss(line);
@@ -131,12 +250,43 @@ public:
         }
     }
 
+    const char* insert_row(const char* p, const char* end, size_t row) override {
+        tbl::FieldCursor f(p, end);
+        s_suppkey[row] = f.int_at(kColumns[0]);
+        s_nationkey[row] = f.int_at(kColumns[1]);
+        return f.next_line();
+    }
+
+    void resize(size_t rows) override {
+        s_suppkey.resize(rows);
+        s_nationkey.resize(rows);
+    }
+
+    void reserve(size_t rows) override {
+        s_suppkey.reserve(rows);
+        s_nationkey.reserve(rows);
+    }
+
+    std::vector<int> columns() const override {
+        return std::vector<int>(std::begin(kColumns), std::end(kColumns));
+    }
+
+    void save_columns(ColumnWriter& out) const override {
+        out.write(s_suppkey);
+        out.write(s_nationkey);
+    }
+
+    bool load_columns(ColumnReader& in) override {
+        return in.read(s_suppkey)
+            && in.read(s_nationkey);
+    }
+
     std::unique_ptr<tables> create_empty() const override {
         return std::make_unique<SupplierSOA>();
     }
 
     void merge_from(const tables& other_base) override {
-        const auto& other = dynamic_cast<const SupplierSOA&>(other_base);
+        const auto& other = static_cast<const SupplierSOA&>(other_base);
         s_suppkey.insert(s_suppkey.end(),
                          other.s_suppkey.begin(), other.s_suppkey.end());
         s_nationkey.insert(s_nationkey.end(),
@@ -145,13 +295,21 @@ public:
     int size() const {
         return s_suppkey.size();
     }
+
+    void clear() override {
+        s_suppkey.clear();
+        s_nationkey.clear();
+    }
 };
 
 class RegionSOA : public tables {
 public:
-    std::vector<int> r_regionkey;
+    Column<int> r_regionkey;
     std::vector<std::string> r_name;
 
+    // r_regionkey, r_name
+    static constexpr int kColumns[] = {0, 1};
+
     void insert_line(const std::string& line) override {
         std::istringstream ss(line);
         std::string value;
@@ -167,12 +325,43 @@ public:
         }
     }
 
+    const char* insert_row(const char* p, const char* end, size_t row) override {
+        tbl::FieldCursor f(p, end);
+        r_regionkey[row] = f.int_at(kColumns[0]);
+        r_name[row] = f.string_at(kColumns[1]);
+        return f.next_line();
+    }
+
+    void resize(size_t rows) override {
+        r_regionkey.resize(rows);
+        r_name.resize(rows);
+    }
+
+    void reserve(size_t rows) override {
+        r_regionkey.reserve(rows);
+        r_name.reserve(rows);
+    }
+
+    std::vector<int> columns() const override {
+        return std::vector<int>(std::begin(kColumns), std::end(kColumns));
+    }
+
+    void save_columns(ColumnWriter& out) const override {
+        out.write(r_regionkey);
+        out.write(r_name);
+    }
+
+    bool load_columns(ColumnReader& in) override {
+        return in.read(r_regionkey)
+            && in.read(r_name);
+    }
+
     std::unique_ptr<tables> create_empty() const override {
         return std::make_unique<RegionSOA>();
     }
 
     void merge_from(const tables& other_base) override {
-        const auto& other = dynamic_cast<const RegionSOA&>(other_base);
+        const auto& other = static_cast<const RegionSOA&>(other_base);
         r_regionkey.insert(r_regionkey.end(),
                            other.r_regionkey.begin(), other.r_regionkey.end());
         r_name.insert(r_name.end(),
@@ -181,14 +370,22 @@ public:
     int size() const {
         return r_regionkey.size();
     }
+
+    void clear() override {
+        r_regionkey.clear();
+        r_name.clear();
+    }
 };
 
 class NationSOA : public tables {
 public:
-    std::vector<int> n_nationkey;
-    std::vector<int> n_regionkey;
+    Column<int> n_nationkey;
+    Column<int> n_regionkey;
     std::vector<std::string> n_name;
 
+    // n_nationkey, n_name, n_regionkey
+    static constexpr int kColumns[] = {0, 1, 2};
+
     void insert_line(const std::string& line) override {
         std::istringstream ss(line);
         std::string value;
@@ -214,12 +411,48 @@ public:
         n_regionkey.push_back(regionkey);
     }
 
+    const char* insert_row(const char* p, const char* end, size_t row) override {
+        tbl::FieldCursor f(p, end);
+        n_nationkey[row] = f.int_at(kColumns[0]);
+        n_name[row] = f.string_at(kColumns[1]);
+        n_regionkey[row] = f.int_at(kColumns[2]);
+        return f.next_line();
+    }
+
+    void resize(size_t rows) override {
+        n_nationkey.resize(rows);
+        n_regionkey.resize(rows);
+        n_name.resize(rows);
+    }
+
+    void reserve(size_t rows) override {
+        n_nationkey.reserve(rows);
+        n_regionkey.reserve(rows);
+        n_name.reserve(rows);
+    }
+
+    std::vector<int> columns() const override {
+        return std::vector<int>(std::begin(kColumns), std::end(kColumns));
+    }
+
+    void save_columns(ColumnWriter& out) const override {
+        out.write(n_nationkey);
+        out.write(n_regionkey);
+        out.write(n_name);
+    }
+
+    bool load_columns(ColumnReader& in) override {
+        return in.read(n_nationkey)
+            && in.read(n_regionkey)
+            && in.read(n_name);
+    }
+
     std::unique_ptr<tables> create_empty() const override {
         return std::make_unique<NationSOA>();
     }
 
     void merge_from(const tables& other_base) override {
-        const auto& other = dynamic_cast<const NationSOA&>(other_base);
+        const auto& other = static_cast<const NationSOA&>(other_base);
 
         n_nationkey.insert(n_nationkey.end(),
                            other.n_nationkey.begin(), other.n_nationkey.end());
@@ -234,15 +467,25 @@ public:
     int size() const {
         return (int)n_nationkey.size();
     }
+
+    void clear() override {
+        n_nationkey.clear();
+        n_regionkey.clear();
+        n_name.clear();
+    }
 };
 
 
 class LineItemSOA : public tables {
 public:
-    std::vector<int>    l_orderkey;
-    std::vector<int>    l_suppkey;
-    std::vector<double> l_extendedprice;
-    std::vector<double> l_discount;
+    Column<int>    l_orderkey;
+    Column<int>    l_suppkey;
+    Column<Cents>  l_extendedprice;
+    Column<Cents>  l_discount;
+    ZoneMap             l_orderkey_zones;   // built once loading is done
+
+    // l_orderkey, l_suppkey, l_extendedprice, l_discount
+    static constexpr int kColumns[] = {0, 2, 5, 6};
 
     void insert_line(const std::string& line) override {
         std::istringstream ss(line);
@@ -254,10 +497,14 @@ public:
                 l_orderkey.push_back(std::stoi(value));
             else if (index == 2)
                 l_suppkey.push_back(std::stoi(value));
-            else if (index == 5)
-                l_extendedprice.push_back(std::stod(value));
-            else if (index == 6)
-                l_discount.push_back(std::stod(value));
+            else if (index == 5 || index == 6) {
+                const char* p = value.c_str();
+                Cents v = tbl::parse_cents(p, p + value.size());
+                if (index == 5)
+                    l_extendedprice.push_back(v);
+                else
+                    l_discount.push_back(v);
+            }
 
             index++;
         }
@@ -265,12 +512,53 @@ public:
         
     }
 
+    const char* insert_row(const char* p, const char* end, size_t row) override {
+        tbl::FieldCursor f(p, end);
+        l_orderkey[row] = f.int_at(kColumns[0]);
+        l_suppkey[row] = f.int_at(kColumns[1]);
+        l_extendedprice[row] = f.cents_at(kColumns[2]);
+        l_discount[row] = f.cents_at(kColumns[3]);
+        return f.next_line();
+    }
+
+    void resize(size_t rows) override {
+        l_orderkey.resize(rows);
+        l_suppkey.resize(rows);
+        l_extendedprice.resize(rows);
+        l_discount.resize(rows);
+    }
+
+    void reserve(size_t rows) override {
+        l_orderkey.reserve(rows);
+        l_suppkey.reserve(rows);
+        l_extendedprice.reserve(rows);
+        l_discount.reserve(rows);
+    }
+
+    std::vector<int> columns() const override {
+        return std::vector<int>(std::begin(kColumns), std::end(kColumns));
+    }
+
+    void save_columns(ColumnWriter& out) const override {
+        out.write(l_orderkey);
+        out.write(l_suppkey);
+        out.write(l_extendedprice);
+        out.write(l_discount);
+    }
+
+    bool load_columns(ColumnReader& in) override {
+        return in.read(l_orderkey)
+            && in.read(l_suppkey)
+            && in.read(l_extendedprice)
+            && in.read(l_discount);
+    }
+
     std::unique_ptr<tables> create_empty() const override {
         return std::make_unique<LineItemSOA>();
     }
 
     void merge_from(const tables& other_base) override {
-        const auto& other = dynamic_cast<const LineItemSOA&>(other_base);   
+        const auto& other = static_cast<const LineItemSOA&>(other_base);   
         l_orderkey.insert(l_orderkey.end(),
                          other.l_orderkey.begin(), other.l_orderkey.end());
         l_suppkey.insert(l_suppkey.end(),
@@ -285,6 +573,82 @@ public:
             return l_orderkey.size();
     }
 
+    void clear() override {
+        l_orderkey.clear();
+        l_suppkey.clear();
+        l_extendedprice.clear();
+        l_discount.clear();
+        l_orderkey_zones.clear();
+    }
+
 };
 
 
+// Read-only compressed copy of a LineItemSOA for in-memory scans: about a
+// quarter of the 24 bytes per row. l_orderkey is delta coded (lineitem.tbl
+// is sorted by it), the other keys and prices are frame-of-reference bit
+// packed and l_discount is dictionary coded. Scans decode one kPackBlock
+// block at a time into a Block buffer.
+// A whole zone is a whole number of blocks, so appends of whole zones pack
+// the same blocks as one encode
+static_assert(kZoneRows % kPackBlock == 0, "zones must hold whole packed blocks");
+
+class PackedLineItemSOA {
+public:
+    PackedColumn l_orderkey;
+    PackedColumn l_suppkey;
+    PackedColumn l_extendedprice;
+    DictionaryColumn<Cents> l_discount;
+    ZoneMap l_orderkey_zones;
+
+    struct Block {
+        alignas(64) int l_orderkey[kPackBlock];
+        alignas(64) int l_suppkey[kPackBlock];
+        alignas(64) Cents l_extendedprice[kPackBlock];
+        alignas(64) Cents l_discount[kPackBlock];
+    };
+
+    // False if a column does not fit its encoding; the source is unchanged
+    bool pack(const LineItemSOA& src, ThreadPool& pool) {
+        clear();
+        return append(src.l_orderkey.data(), src.l_suppkey.data(), src.l_extendedprice.data(),
+                      src.l_discount.data(), src.l_orderkey.size(), pool);
+    }
+
+    // Packs n more rows from raw column arrays. Rows so far must be a whole
+    // number of zones, so a table can be packed a segment at a time. False
+    // if l_discount outgrows its dictionary
+    bool append(const int* orderkey, const int* suppkey, const Cents* extendedprice,
+                const Cents* discount, size_t n, ThreadPool& pool) {
+        if (!l_discount.append(discount, n, pool))
+            return false;
+        l_orderkey.append(orderkey, n, PackedColumn::Encoding::Delta, pool);
+        l_suppkey.append(suppkey, n, PackedColumn::Encoding::FrameOfReference, pool);
+        l_extendedprice.append(extendedprice, n, PackedColumn::Encoding::FrameOfReference, pool);
+        l_orderkey_zones.append(orderkey, n, pool);
+        return true;
+    }
+
+    void clear() {
+        l_orderkey.clear();
+        l_suppkey.clear();
+        l_extendedprice.clear();
+        l_discount.clear();
+        l_orderkey_zones.clear();
+    }
+
+    // Rows of block b land in out[0, block_rows(b))
+    void decode_block(size_t b, Block& out) const {
+        l_orderkey.decode_block(b, out.l_orderkey);
+        l_suppkey.decode_block(b, out.l_suppkey);
+        l_extendedprice.decode_block(b, out.l_extendedprice);
+        l_discount.decode_block(b, out.l_discount);
+    }
+
+    size_t size() const { return l_orderkey.size(); }
+    size_t num_blocks() const { return l_orderkey.num_blocks(); }
+    size_t block_rows(size_t b) const { return l_orderkey.block_rows(b); }
+    size_t bytes() const {
+        return l_orderkey.bytes() + l_suppkey.bytes() + l_extendedprice.bytes() + l_discount.bytes();
+    }
+};
@@ -0,0 +1,205 @@
+#pragma once
+#include <string>
+#include <cstring>
+#include <cstdint>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// In-place scanners for dbgen '|'-delimited .tbl rows. Every function takes
+// a cursor into the mapped file and leaves it on the byte that ended the
+// value (normally the '|' delimiter); nothing is allocated. The mapping is
+// not padded, so every scanner stops at `end` even when the file's last
+// value has no delimiter after it.
+namespace tbl {
+
+inline bool is_digit(char c) {
+    return static_cast<unsigned>(c - '0') < 10u;
+}
+
+inline int parse_int(const char*& p, const char* end) {
+    bool neg = (p < end && *p == '-');
+    if (neg) ++p;
+
+    int v = 0;
+    while (p < end && is_digit(*p)) {
+        v = v * 10 + (*p - '0');
+        ++p;
+    }
+    return neg ? -v : v;
+}
+
+// Parses a decimal such as "123.45" into hundredths (12345). Missing
+// decimals are padded and any beyond the second are truncated.
+inline int64_t parse_cents(const char*& p, const char* end) {
+    bool neg = (p < end && *p == '-');
+    if (neg) ++p;
+
+    int64_t v = 0;
+    while (p < end && is_digit(*p)) {
+        v = v * 10 + (*p - '0');
+        ++p;
+    }
+
+    int scale = 0;
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && is_digit(*p)) {
+            if (scale < 2) {
+                v = v * 10 + (*p - '0');
+                ++scale;
+            }
+            ++p;
+        }
+    }
+    for (; scale < 2; ++scale)
+        v *= 10;
+
+    return neg ? -v : v;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (Hinnant's
+// days_from_civil), so dates compare and subtract as plain integers
+inline int days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int>(doe) - 719468;
+}
+
+// Parses a fixed-width "YYYY-MM-DD" date into days since the epoch; a
+// field cut short by `end` reads as the epoch
+inline int parse_date(const char*& p, const char* end) {
+    if (end - p < 10) {
+        p = end;
+        return 0;
+    }
+    auto two = [](const char* c) { return (c[0] - '0') * 10 + (c[1] - '0'); };
+    int y = two(p) * 100 + two(p + 2);
+    int m = two(p + 5);
+    int d = two(p + 8);
+    p += 10;
+    return days_from_civil(y, m, d);
+}
+
+inline int days_in_month(int y, int m) {
+    static const int kDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    const bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    return m == 2 && leap ? 29 : kDays[m - 1];
+}
+
+// Checked variant for user input such as --start_date: the shape and the
+// calendar (month 1-12, day within that month) are both validated
+inline bool parse_date(const std::string& s, int& days) {
+    if (s.size() != 10 || s[4] != '-' || s[7] != '-')
+        return false;
+    for (int i : {0, 1, 2, 3, 5, 6, 8, 9})
+        if (!is_digit(s[i])) return false;
+
+    const int y = std::stoi(s.substr(0, 4));
+    const int m = std::stoi(s.substr(5, 2));
+    const int d = std::stoi(s.substr(8, 2));
+    if (m < 1 || m > 12 || d < 1 || d > days_in_month(y, m))
+        return false;
+
+    const char* p = s.data();
+    days = parse_date(p, p + s.size());
+    return true;
+}
+
+// Moves the cursor past the next '|' (or onto the end of the line).
+inline void skip_field(const char*& p, const char* end) {
+    while (p < end && *p != '|' && *p != '\n') ++p;
+    if (p < end && *p == '|') ++p;
+}
+
+// Copies the current field; only used for the tiny nation/region tables.
+inline std::string read_field(const char*& p, const char* end) {
+    const char* s = p;
+    while (p < end && *p != '|' && *p != '\n') ++p;
+    return std::string(s, p);
+}
+
+// Returns the start of the line following p. memchr is already a vectorized
+// scan in every libc we build against.
+inline const char* next_line(const char* p, const char* end) {
+    if (p >= end) return end;
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+// Moves past n '|' delimiters and returns the first byte after the last one.
+// Delimiters are located a vector at a time and counted with popcount, so a
+// run of unneeded columns costs one compare per 16/32 bytes instead of one
+// per byte. Rows must be well formed: the caller never asks for more fields
+// than the line has.
+inline const char* skip_fields(const char* p, const char* end, int n) {
+    if (n <= 0) return p;
+
+#if defined(__AVX2__)
+    const __m256i bar32 = _mm256_set1_epi8('|');
+    while (p + 32 <= end) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, bar32)));
+        int count = __builtin_popcount(mask);
+        if (count < n) {
+            n -= count;
+            p += 32;
+            continue;
+        }
+        while (--n) mask &= mask - 1;
+        return p + __builtin_ctz(mask) + 1;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i bar16 = _mm_set1_epi8('|');
+    while (p + 16 <= end) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, bar16)));
+        int count = __builtin_popcount(mask);
+        if (count < n) {
+            n -= count;
+            p += 16;
+            continue;
+        }
+        while (--n) mask &= mask - 1;
+        return p + __builtin_ctz(mask) + 1;
+    }
+#endif
+    while (p < end) {
+        if (*p++ == '|' && --n == 0)
+            return p;
+    }
+    return end;
+}
+
+// Walks the projected columns of one row in increasing index order. Columns
+// in between are skipped with skip_fields, and the rest of the line after the
+// last projected column is never tokenized.
+class FieldCursor {
+public:
+    FieldCursor(const char* p, const char* end) : p_(p), end_(end) {}
+
+    // Positions the cursor at the start of column col (col >= current column)
+    const char*& at(int col) {
+        p_ = skip_fields(p_, end_, col - col_);
+        col_ = col;
+        return p_;
+    }
+
+    int int_at(int col) { return parse_int(at(col), end_); }
+    int64_t cents_at(int col) { return parse_cents(at(col), end_); }
+    int date_at(int col) { return parse_date(at(col), end_); }
+    std::string string_at(int col) { return read_field(at(col), end_); }
+
+    const char* next_line() const { return tbl::next_line(p_, end_); }
+
+private:
+    const char* p_;
+    const char* end_;
+    int col_ = 0;
+};
+
+} // namespace tbl
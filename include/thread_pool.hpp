@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool shared by the loader and the query phases.
+//
+// A job is a number of independent tasks (morsels). run() deals the task
+// indices out to per-worker deques in contiguous blocks; each worker pops
+// from the front of its own deque and, once it is empty, steals from the back
+// of the others, so a slow morsel no longer holds up a whole static chunk.
+// The calling thread works as worker 0, so a pool of n threads starts n - 1.
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t task, int worker)>;
+
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of workers, including the calling thread
+    int size() const { return static_cast<int>(queues_.size()); }
+
+    // Runs fn(task, worker) for every task in [0, num_tasks) and waits for all
+    // of them. The first exception thrown by a task is rethrown here. Not
+    // reentrant: tasks must not call run() on the same pool.
+    void run(size_t num_tasks, const Task& fn);
+
+    // As run(), but without stealing: every worker runs exactly the block of
+    // tasks dealt to it, so with num_tasks == size() task w runs on worker w.
+    // For work that must happen on a particular worker's thread (or core,
+    // once pinned), such as per-node memory measurements.
+    void run_pinned(size_t num_tasks, const Task& fn);
+
+    // Total time worker w has spent running tasks, for phase profiling
+    uint64_t busy_ns(int worker) const { return queues_[worker]->busy_ns.load(std::memory_order_relaxed); }
+
+    // Kernel thread id of worker w (worker 0: the thread that last called run())
+    int thread_id(int worker) const { return queues_[worker]->tid.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) WorkerQueue {
+        std::mutex m;
+        std::deque<size_t> tasks;
+        std::atomic<uint64_t> busy_ns{0};
+        std::atomic<int> tid{0};
+    };
+
+    void dispatch(size_t num_tasks, const Task& fn, bool allow_steal);
+    void worker_loop(int worker);
+    void drain(int worker);
+    bool pop_own(int worker, size_t& task);
+    bool steal(int worker, size_t& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex run_mutex_;
+    std::mutex m_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const Task* job_ = nullptr;
+    bool allow_steal_ = true;
+    unsigned long generation_ = 0;
+    int active_ = 0;
+    bool stop_ = false;
+
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
+
+// Splits [0, total) into morsels of `morsel` items and runs
+// fn(begin, end, worker) for each of them on the pool.
+template <typename Fn>
+void parallel_for(ThreadPool& pool, size_t total, size_t morsel, Fn&& fn) {
+    if (total == 0) return;
+    if (morsel == 0) morsel = 1;
+    size_t num_tasks = (total + morsel - 1) / morsel;
+    pool.run(num_tasks, [&](size_t task, int worker) {
+        size_t begin = task * morsel;
+        size_t end = begin + morsel < total ? begin + morsel : total;
+        fn(begin, end, worker);
+    });
+}
+
+// Rows per query-phase morsel
+constexpr size_t kRowMorsel = 64 * 1024;
+
+// Bytes of .tbl file per load morsel
+constexpr size_t kFileMorsel = 1 << 20;
+
+// Process-wide pool with num_threads workers; rebuilt if the count changes
+ThreadPool& shared_pool(int num_threads);
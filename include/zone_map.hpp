@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include "thread_pool.hpp"
+
+// Rows per zone; one zone is exactly one query morsel
+constexpr size_t kZoneRows = kRowMorsel;
+
+// Min/max statistics of an int column per kZoneRows rows, so a scan can
+// skip whole zones that cannot satisfy a range predicate. A zone map that
+// was never built (or is stale) answers "may match" for every zone.
+class ZoneMap {
+public:
+    struct Zone {
+        int min;
+        int max;
+    };
+
+    template <typename Alloc>
+    void build(const std::vector<int, Alloc>& column, ThreadPool& pool) {
+        clear();
+        append(column.data(), column.size(), pool);
+    }
+
+    // Extends the map by values[0, n); rows so far must be a whole number of zones
+    void append(const int* values, size_t n, ThreadPool& pool) {
+        const size_t first = zones_.size();
+        rows_ += n;
+        zones_.resize((rows_ + kZoneRows - 1) / kZoneRows);
+        parallel_for(pool, n, kZoneRows, [&](size_t begin, size_t end, int) {
+            auto [lo, hi] = std::minmax_element(values + begin, values + end);
+            zones_[first + begin / kZoneRows] = Zone{*lo, *hi};
+        });
+    }
+
+    void clear() {
+        zones_.clear();
+        rows_ = 0;
+    }
+
+    // False only if every row of the zone starting at `row` is outside [lo, hi]
+    bool may_overlap(size_t row, int lo, int hi) const {
+        size_t z = row / kZoneRows;
+        return z >= zones_.size() || (zones_[z].max >= lo && zones_[z].min <= hi);
+    }
+
+    // Zone statistics for the rows starting at `row`, if they were built
+    const Zone* zone_at(size_t row) const {
+        size_t z = row / kZoneRows;
+        return z < zones_.size() ? &zones_[z] : nullptr;
+    }
+
+    // Whether the map describes a column of `rows` rows
+    bool covers(size_t rows) const { return !zones_.empty() && rows_ == rows; }
+
+private:
+    std::vector<Zone> zones_;
+    size_t rows_ = 0;
+};
@@ -0,0 +1,96 @@
+#include "column_cache.hpp"
+#include "tables_soa.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+bool stat_source(const std::string& tbl_path, uint64_t& size, int64_t& mtime_ns) {
+    struct stat st;
+    if (stat(tbl_path.c_str(), &st) != 0)
+        return false;
+    size = static_cast<uint64_t>(st.st_size);
+    mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+} // namespace
+
+std::string cache_path_for(const std::string& tbl_path) {
+    return tbl_path + ".colcache";
+}
+
+bool open_cached_table(const std::string& tbl_path, const tables& table, MappedFile& mapped,
+                       ColumnReader& reader) {
+    uint64_t source_size = 0;
+    int64_t source_mtime = 0;
+    if (!stat_source(tbl_path, source_size, source_mtime))
+        return false;
+
+    if (!mapped.open(cache_path_for(tbl_path)) || mapped.size() < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader h;
+    std::memcpy(&h, mapped.data(), sizeof(h));
+    if (std::memcmp(h.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+        h.version != kCacheSchemaVersion ||
+        h.num_columns != table.columns().size() ||
+        h.source_size != source_size ||
+        h.source_mtime_ns != source_mtime)
+        return false;
+
+    reader = ColumnReader(mapped.data() + sizeof(h), mapped.data() + mapped.size(), h.rows);
+    return true;
+}
+
+bool load_cached_table(const std::string& tbl_path, tables& table) {
+    MappedFile mapped;
+    ColumnReader reader;
+    if (!open_cached_table(tbl_path, table, mapped, reader))
+        return false;
+
+    if (!table.load_columns(reader)) {
+        // Leave no half-filled columns behind for the text loader
+        table.clear();
+        return false;
+    }
+    return true;
+}
+
+bool save_cached_table(const std::string& tbl_path, const tables& table) {
+    CacheHeader h;
+    std::memcpy(h.magic, kCacheMagic, sizeof(kCacheMagic));
+    h.version = kCacheSchemaVersion;
+    h.rows = static_cast<uint64_t>(table.size());
+    if (!stat_source(tbl_path, h.source_size, h.source_mtime_ns))
+        return false;
+
+    // Write to a temporary file private to this process and rename, so a
+    // concurrent run neither maps a partially written cache nor shares the
+    // temporary file
+    std::string path = cache_path_for(tbl_path);
+    std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Failed to write column cache: " << tmp << std::endl;
+            return false;
+        }
+        ColumnWriter writer(out);
+        table.save_columns(writer);
+        h.num_columns = writer.num_columns();
+        if (!writer.finish(h)) {
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
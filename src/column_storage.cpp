@@ -0,0 +1,107 @@
+#include "column_storage.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+#include <sys/mman.h>
+
+namespace {
+
+std::atomic<HugePageMode> g_mode{HugePageMode::Thp};
+std::atomic<size_t> g_mapped{0};
+std::atomic<size_t> g_hugetlb{0};
+
+// Mappings from the explicit pool are tagged in a side table so unmap can
+// keep the statistics right. Only columns of 2 MB and up are mapped, so the
+// table stays small and a mutex is cheap next to the mmap itself.
+std::mutex g_hugetlb_mutex;
+std::unordered_set<void*> g_hugetlb_columns;
+
+void remember_hugetlb(void* p) {
+    std::lock_guard<std::mutex> lock(g_hugetlb_mutex);
+    g_hugetlb_columns.insert(p);
+}
+
+bool forget_hugetlb(void* p) {
+    std::lock_guard<std::mutex> lock(g_hugetlb_mutex);
+    return g_hugetlb_columns.erase(p) != 0;
+}
+
+// 2 MB-aligned anonymous mapping of `bytes` (a multiple of 2 MB): map one
+// huge page more than needed and trim both ends
+void* map_aligned(size_t bytes) {
+    const size_t span = bytes + kHugePageBytes;
+    void* raw = ::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + kHugePageBytes - 1) & ~(uintptr_t(kHugePageBytes) - 1);
+    if (aligned > start)
+        ::munmap(raw, aligned - start);
+    uintptr_t tail = aligned + bytes;
+    uintptr_t end = start + span;
+    if (end > tail)
+        ::munmap(reinterpret_cast<void*>(tail), end - tail);
+    return reinterpret_cast<void*>(aligned);
+}
+
+} // namespace
+
+
+void set_column_huge_pages(HugePageMode mode) {
+    g_mode.store(mode, std::memory_order_relaxed);
+}
+
+HugePageMode column_huge_pages() {
+    return g_mode.load(std::memory_order_relaxed);
+}
+
+void* map_column(size_t bytes) {
+    const size_t size = mapped_column_bytes(bytes);
+    const HugePageMode mode = column_huge_pages();
+
+#if defined(MAP_HUGETLB)
+    if (mode == HugePageMode::Explicit) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            try {
+                remember_hugetlb(p);
+                g_hugetlb.fetch_add(size, std::memory_order_relaxed);
+                g_mapped.fetch_add(size, std::memory_order_relaxed);
+                return p;
+            } catch (const std::bad_alloc&) {
+                // Untracked pool pages would be miscounted on unmap
+                ::munmap(p, size);
+            }
+        }
+        // Pool empty or not configured: fall through to transparent huge pages
+    }
+#endif
+
+    void* p = map_aligned(size);
+    if (!p) return nullptr;
+#if defined(MADV_HUGEPAGE)
+    if (mode != HugePageMode::Off)
+        ::madvise(p, size, MADV_HUGEPAGE);
+#endif
+    g_mapped.fetch_add(size, std::memory_order_relaxed);
+    return p;
+}
+
+void unmap_column(void* p, size_t bytes) {
+    const size_t size = mapped_column_bytes(bytes);
+    if (forget_hugetlb(p))
+        g_hugetlb.fetch_sub(size, std::memory_order_relaxed);
+    g_mapped.fetch_sub(size, std::memory_order_relaxed);
+    ::munmap(p, size);
+}
+
+size_t mapped_column_total() {
+    return g_mapped.load(std::memory_order_relaxed);
+}
+
+size_t mapped_column_hugetlb() {
+    return g_hugetlb.load(std::memory_order_relaxed);
+}
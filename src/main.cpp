@@ -1,4 +1,6 @@
 #include "query5.hpp"
+#include "server.hpp"
+#include "profiler.hpp"
 // #include"tables_soa.hpp"
 #include <iostream>
 #include <string>
@@ -22,6 +24,11 @@ int main(int argc, char* argv[]) {
         std::cerr << "Failed to parse command line arguments." << std::endl;
         return 1;
     }
+    // In stdin server mode stdout carries only replies; logs go to stderr
+    std::ostream replies(std::cout.rdbuf());
+    if (g_config.serve == "stdin")
+        std::cout.rdbuf(std::cerr.rdbuf());
+
     std::cout << "Arguments parsed successfully." << std::endl;
     std::cout << "Region Name: " << g_config.r_name << std::endl;
     std::cout << "Start Date: " << g_config.start_date << std::endl; 
@@ -30,29 +37,53 @@ int main(int argc, char* argv[]) {
     std::cout << "Table Path: " << g_config.table_path << std::endl;
     std::cout << "Result Path: " << g_config.result_path << std::endl;
 
+    if (!g_config.report_path.empty())
+        enable_profiling(g_config.perf_counters);
+    auto write_report = [](int status) {
+        if (!g_config.report_path.empty() && !write_profile_report(g_config.report_path)) {
+            std::cerr << "Failed to write profile report to " << g_config.report_path << std::endl;
+            return status ? status : 1;
+        }
+        return status;
+    };
+
     auto t0 = Clock::now();
 
-    // tables customer_data = CustomerSOA(), orders_data = OrdersSOA(), lineitem_data = LineItemSOA(), supplier_data = SupplierSOA(), nation_data = NationSOA(), region_data = RegionSOA();
-    CustomerSOA customer_data;
-    OrdersSOA orders_data;
-    LineItemSOA lineitem_data;
-    SupplierSOA supplier_data;
-    NationSOA nation_data;
-    RegionSOA region_data;
-    if (!readTPCHData(g_config.table_path, customer_data, orders_data, lineitem_data, supplier_data, nation_data, region_data)) {
+    TPCHData data;
+    if (!loadTPCHData(g_config.table_path, data)) {
         std::cout << "Failed to read TPCH data." << std::endl;
         return 1;
     }
 
-    
     std::map<std::string, double> results;
     auto t1 = Clock::now();
     auto load_duration = std::chrono::duration_cast<ms>(t1 - t0).count();
     std::cout << "Data loading completed in " << load_duration << " ms." << std::endl;
 
+    if (!g_config.serve.empty())
+        return write_report(run_server(g_config.serve, data, replies) ? 0 : 1);
+
+    if (!g_config.batch_file.empty()) {
+        std::vector<Q5Params> params;
+        std::vector<std::map<std::string, double>> batch_results;
+        auto b0 = Clock::now();
+        if (!readBatchFile(g_config.batch_file, params) ||
+            !executeQuery5Batch(data, params, g_config.num_threads, batch_results)) {
+            std::cout << "Failed to execute the TPCH Query 5 batch." << std::endl;
+            return 1;
+        }
+        auto batch_duration = std::chrono::duration_cast<ms>(Clock::now() - b0).count();
+        std::cout << "Batch of " << params.size() << " queries completed in " << batch_duration << " ms." << std::endl;
+        if (!outputBatchResults(g_config.result_path, params, batch_results)) {
+            std::cerr << "Failed to output results." << std::endl;
+            return 1;
+        }
+        return write_report(0);
+    }
 
     auto t2 = Clock::now();
-    if (!executeQuery5(g_config.r_name, g_config.start_date, g_config.end_date, g_config.num_threads, customer_data, orders_data, lineitem_data, supplier_data, nation_data, region_data, results)) {
+    bool ok = runQuery5(data, g_config.r_name, g_config.start_date, g_config.end_date, g_config.num_threads, results);
+    if (!ok) {
         std::cout << "Failed to execute TPCH Query 5." << std::endl;
         return 1;
     }
@@ -68,5 +99,5 @@ int main(int argc, char* argv[]) {
 
     std::cout << "TPCH Query 5 implementation completed." << std::endl;
 
-    return 0;
+    return write_report(0);
 } 
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "numa.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// From <linux/mempolicy.h>
+constexpr int kMpolPreferred = 1;
+constexpr unsigned kMpolMfMove = 1u << 1;
+
+// "0-3,8-11" -> {0, 1, 2, 3, 8, 9, 10, 11}
+std::vector<int> parse_cpulist(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        int lo = std::stoi(range.substr(0, dash));
+        int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+        for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+NumaTopology read_topology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    NumaTopology topo;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string nodes;
+    if (online && std::getline(online, nodes)) {
+        for (int node : parse_cpulist(nodes)) {
+            std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string list;
+            if (!f || !std::getline(f, list)) continue;
+            std::vector<int> cpus;
+            for (int c : parse_cpulist(list))
+                if (!have_mask || CPU_ISSET(c, &allowed)) cpus.push_back(c);
+            if (cpus.empty()) continue;   // memory-only node, or none of ours
+            topo.node_ids.push_back(node);
+            topo.node_cpus.push_back(cpus);
+        }
+    }
+
+    // No sysfs node information: one node with every allowed CPU
+    if (topo.node_ids.empty()) {
+        std::vector<int> cpus;
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+            if (have_mask && CPU_ISSET(c, &allowed)) cpus.push_back(c);
+        if (cpus.empty()) cpus.push_back(0);
+        topo.node_ids.push_back(0);
+        topo.node_cpus.push_back(cpus);
+    }
+    return topo;
+}
+
+// First worker of the block pinned to node n
+int first_worker(int n, int num_workers, int num_nodes) {
+    return static_cast<int>((static_cast<long>(num_workers) * n + num_nodes - 1) / num_nodes);
+}
+
+// Rows of worker w's initial block of morsels, as ThreadPool::run deals
+// them. A scan run with stealing may still hand some of these morsels to
+// other workers; run_pinned keeps every one on worker w.
+void worker_rows(size_t rows, size_t morsel, int workers, int w, size_t& begin, size_t& end) {
+    size_t tasks = (rows + morsel - 1) / morsel;
+    begin = std::min(rows, tasks * w / workers * morsel);
+    end = std::min(rows, tasks * (w + 1) / workers * morsel);
+}
+
+size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Streams through [p, p + bytes) eight bytes at a time
+uint64_t read_sum(const char* p, size_t bytes) {
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(p);
+    size_t n = bytes / sizeof(uint64_t);
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += words[i];
+        s1 += words[i + 1];
+        s2 += words[i + 2];
+        s3 += words[i + 3];
+    }
+    for (; i < n; ++i) s0 += words[i];
+    return s0 + s1 + s2 + s3;
+}
+
+} // namespace
+
+
+const NumaTopology& numa_topology() {
+    static const NumaTopology topo = read_topology();
+    return topo;
+}
+
+int numa_worker_node(int worker, int num_workers) {
+    const int nodes = numa_topology().num_nodes();
+    int n = static_cast<int>(static_cast<long>(worker) * nodes / num_workers);
+    return std::min(n, nodes - 1);
+}
+
+bool numa_pin_pool(ThreadPool& pool) {
+    const NumaTopology& topo = numa_topology();
+    const int workers = pool.size();
+    bool ok = true;
+    for (int w = 0; w < workers; ++w) {
+        int node = numa_worker_node(w, workers);
+        const std::vector<int>& cpus = topo.node_cpus[node];
+        int slot = w - first_worker(node, workers, topo.num_nodes());
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[static_cast<size_t>(slot) % cpus.size()], &set);
+        if (sched_setaffinity(pool.thread_id(w), sizeof(set), &set) != 0) ok = false;
+    }
+    return ok;
+}
+
+size_t numa_place_columns(ThreadPool& pool, const std::vector<NumaColumn>& columns, size_t rows,
+                          size_t morsel, bool& ok) {
+    ok = true;
+    const NumaTopology& topo = numa_topology();
+    if (topo.num_nodes() < 2 || rows == 0) return 0;
+
+    const int workers = pool.size();
+    const uintptr_t page = page_size();
+    size_t placed = 0;
+    for (const NumaColumn& col : columns) {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(col.data);
+        for (int w = 0; w < workers; ++w) {
+            size_t begin, end;
+            worker_rows(rows, morsel, workers, w, begin, end);
+            if (begin == end) continue;
+            // A page shared by two workers goes to the later one
+            uintptr_t lo = (base + begin * col.width) & ~(page - 1);
+            uintptr_t hi = w + 1 == workers ? base + end * col.width : (base + end * col.width) & ~(page - 1);
+            if (hi <= lo) continue;
+
+            const int node = topo.node_ids[numa_worker_node(w, workers)];
+            if (node >= static_cast<int>(sizeof(unsigned long) * 8)) {
+                ok = false;
+                return placed;
+            }
+            unsigned long mask = 1ul << node;
+            if (::syscall(SYS_mbind, lo, hi - lo, kMpolPreferred, &mask, sizeof(mask) * 8 + 1,
+                          kMpolMfMove) != 0) {
+                ok = false;
+                return placed;
+            }
+            placed += hi - lo;
+        }
+    }
+    return placed;
+}
+
+double numa_local_fraction(ThreadPool& pool, const std::vector<NumaColumn>& columns, size_t rows,
+                           size_t morsel) {
+    const NumaTopology& topo = numa_topology();
+    const int workers = pool.size();
+    const size_t page = page_size();
+    constexpr size_t kSampleStride = 64;   // pages
+
+    size_t local = 0, sampled = 0;
+    for (const NumaColumn& col : columns) {
+        for (int w = 0; w < workers; ++w) {
+            size_t begin, end;
+            worker_rows(rows, morsel, workers, w, begin, end);
+            std::vector<void*> pages;
+            const char* p = static_cast<const char*>(col.data);
+            for (size_t off = begin * col.width; off < end * col.width; off += page * kSampleStride)
+                pages.push_back(const_cast<char*>(p + off));
+            if (pages.empty()) continue;
+
+            std::vector<int> status(pages.size(), -1);
+            if (::syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+                return -1.0;
+            const int node = topo.node_ids[numa_worker_node(w, workers)];
+            for (int s : status) {
+                if (s < 0) continue;   // not faulted in, or unknown
+                ++sampled;
+                local += s == node;
+            }
+        }
+    }
+    return sampled ? static_cast<double>(local) / sampled : -1.0;
+}
+
+std::vector<NumaBandwidth> numa_measure_bandwidth(ThreadPool& pool, const std::vector<NumaColumn>& columns,
+                                                  size_t rows, size_t morsel) {
+    const NumaTopology& topo = numa_topology();
+    const int workers = pool.size();
+    const int nodes = topo.num_nodes();
+
+    // Per worker: bytes and time reading local, then remote partitions
+    std::vector<uint64_t> bytes[2], ns[2];
+    for (int k = 0; k < 2; ++k) {
+        bytes[k].assign(workers, 0);
+        ns[k].assign(workers, 0);
+    }
+    std::atomic<uint64_t> sink{0};
+
+    for (int remote = 0; remote < (nodes > 1 ? 2 : 1); ++remote) {
+        // One task per worker, pinned so that no worker steals another's
+        // read and each timing belongs to the thread on the worker's core
+        pool.run_pinned(static_cast<size_t>(workers), [&](size_t, int worker) {
+            int owner = worker;
+            if (remote) {
+                // The same slot in the next node's block of workers
+                int node = numa_worker_node(owner, workers);
+                int next = (node + 1) % nodes;
+                owner = first_worker(next, workers, nodes) + (owner - first_worker(node, workers, nodes));
+                owner = std::min(owner, first_worker(next + 1, workers, nodes) - 1);
+            }
+            size_t begin, end;
+            worker_rows(rows, morsel, workers, owner, begin, end);
+            uint64_t t0 = now_ns(), sum = 0, read = 0;
+            for (const NumaColumn& col : columns) {
+                const char* p = static_cast<const char*>(col.data);
+                sum += read_sum(p + begin * col.width, (end - begin) * col.width);
+                read += (end - begin) * col.width;
+            }
+            bytes[remote][worker] += read;
+            ns[remote][worker] += now_ns() - t0;
+            sink.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+
+    // A node's bandwidth: its bytes over its slowest worker's time
+    std::vector<NumaBandwidth> report;
+    for (int n = 0; n < nodes; ++n) {
+        NumaBandwidth b{topo.node_ids[n], 0, 0.0, 0.0};
+        uint64_t total[2] = {0, 0}, slowest[2] = {0, 0};
+        for (int w = 0; w < workers; ++w) {
+            if (numa_worker_node(w, workers) != n) continue;
+            ++b.workers;
+            for (int k = 0; k < 2; ++k) {
+                total[k] += bytes[k][w];
+                slowest[k] = std::max(slowest[k], ns[k][w]);
+            }
+        }
+        b.local_gbs = slowest[0] ? static_cast<double>(total[0]) / slowest[0] : 0.0;
+        b.remote_gbs = slowest[1] ? static_cast<double>(total[1]) / slowest[1] : 0.0;
+        report.push_back(b);
+    }
+    return report;
+}
@@ -0,0 +1,120 @@
+#include "probe_kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TPCH_HAVE_X86_KERNELS 1
+#endif
+
+#ifdef TPCH_HAVE_X86_KERNELS
+
+namespace {
+
+// Gathers nation bytes for 8 keys: a 32-bit gather at the byte offset,
+// sign-extended from its low byte. Keys outside [0, slots) read as -1.
+__attribute__((target("avx2")))
+inline __m256i gather_nations(const int8_t* nations, size_t slots, __m256i keys) {
+    const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+    const __m256i in_range = _mm256_cmpgt_epi32(
+        _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(slots) ^ 0x80000000u)),
+        _mm256_xor_si256(keys, bias));
+    __m256i raw = _mm256_mask_i32gather_epi32(_mm256_set1_epi32(-1),
+                                              reinterpret_cast<const int*>(nations),
+                                              keys, in_range, 1);
+    return _mm256_srai_epi32(_mm256_slli_epi32(raw, 24), 24);
+}
+
+// Low 64 bits of a * b per lane, the same wrapped two's complement product
+// the scalar int64 multiply gives. AVX2 has only a 32x32 -> 64 multiply, so
+// the cross terms of the high halves are added in shifted by 32.
+__attribute__((target("avx2")))
+inline __m256i mul_epi64(__m256i a, __m256i b) {
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                     _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+} // namespace
+
+__attribute__((target("avx2")))
+void probe_dense_avx2(const LineItemColumns& cols, size_t start, size_t end,
+                      const DenseProbeTables& tables, NationAccumulator& acc) {
+    int nation_ids[kMaxNations];
+    int num_nations = 0;
+    for (int n = 0; n < kMaxNations; ++n)
+        if (nation_in_set(tables.nations, n)) nation_ids[num_nations++] = n;
+
+    // Revenue lanes: two 4 x int64 halves per candidate nation
+    __m256i rev_lo[kMaxNations], rev_hi[kMaxNations];
+    for (int j = 0; j < num_nations; ++j)
+        rev_lo[j] = rev_hi[j] = _mm256_setzero_si256();
+
+    const __m256i minus_one = _mm256_set1_epi32(-1);
+    const __m256i hundred = _mm256_set1_epi64x(kCentScale);
+
+    size_t i = start;
+    for (; i + 8 <= end; i += 8) {
+        __m256i okeys = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols.orderkey + i));
+        __m256i skeys = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols.suppkey + i));
+        __m256i onat = gather_nations(tables.order_nation, tables.order_slots, okeys);
+        __m256i snat = gather_nations(tables.supp_nation, tables.supp_slots, skeys);
+
+        __m256i match = _mm256_andnot_si256(_mm256_cmpeq_epi32(onat, minus_one),
+                                            _mm256_cmpeq_epi32(onat, snat));
+        if (_mm256_testz_si256(match, match))
+            continue;
+
+        // price * (100 - discount) as a full 64-bit multiply, so prices of
+        // 2^32 cents and up or discounts outside 0-100 match the scalar path
+        __m256i p_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols.extendedprice + i));
+        __m256i p_hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols.extendedprice + i + 4));
+        __m256i d_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols.discount + i));
+        __m256i d_hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cols.discount + i + 4));
+        __m256i r_lo = mul_epi64(p_lo, _mm256_sub_epi64(hundred, d_lo));
+        __m256i r_hi = mul_epi64(p_hi, _mm256_sub_epi64(hundred, d_hi));
+
+        for (int j = 0; j < num_nations; ++j) {
+            __m256i sel = _mm256_and_si256(match, _mm256_cmpeq_epi32(onat, _mm256_set1_epi32(nation_ids[j])));
+            int bits = _mm256_movemask_ps(_mm256_castsi256_ps(sel));
+            if (bits == 0) continue;
+
+            acc.rows[nation_ids[j]] += __builtin_popcount(static_cast<unsigned>(bits));
+            __m256i sel_lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(sel));
+            __m256i sel_hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(sel, 1));
+            rev_lo[j] = _mm256_add_epi64(rev_lo[j], _mm256_and_si256(r_lo, sel_lo));
+            rev_hi[j] = _mm256_add_epi64(rev_hi[j], _mm256_and_si256(r_hi, sel_hi));
+        }
+    }
+
+    for (int j = 0; j < num_nations; ++j) {
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(rev_lo[j], rev_hi[j]));
+        acc.revenue[nation_ids[j]] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    // Tail rows
+    for (; i < end; ++i) {
+        int ok = cols.orderkey[i];
+        int sk = cols.suppkey[i];
+        int8_t on = static_cast<size_t>(ok) < tables.order_slots ? tables.order_nation[ok] : -1;
+        if (on < 0) continue;
+        int8_t sn = static_cast<size_t>(sk) < tables.supp_slots ? tables.supp_nation[sk] : -1;
+        if (sn != on) continue;
+        acc.add(on, discounted_revenue(cols.extendedprice[i], cols.discount[i]));
+    }
+}
+
+ProbeKernel select_probe_kernel() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return probe_dense_avx2;
+    return nullptr;
+}
+
+#else
+
+ProbeKernel select_probe_kernel() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,248 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+// cycles, instructions, LLC misses
+constexpr int kCounters = 3;
+
+struct ProfilerState {
+    bool enabled = false;
+    bool hardware_counters = false;
+    std::string counter_error;   // why counters are unavailable, if they are
+    std::mutex m;
+    std::vector<PhaseRecord> phases;
+
+    // Counter fds per pool thread id
+    std::vector<int> counter_tids;
+    std::vector<int> counter_fds;
+};
+
+ProfilerState& state() {
+    static ProfilerState s;
+    return s;
+}
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#if defined(__linux__)
+int open_counter(int tid, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+}
+#endif
+
+// Opens counters for every thread of the pool the first time it is seen
+void ensure_counters(ThreadPool& pool) {
+    ProfilerState& s = state();
+    if (!s.hardware_counters || !s.counter_error.empty()) return;
+
+    std::vector<int> tids;
+    for (int w = 0; w < pool.size(); ++w)
+        tids.push_back(pool.thread_id(w));
+    if (tids == s.counter_tids) return;
+
+    for (int fd : s.counter_fds)
+        if (fd >= 0) ::close(fd);
+    s.counter_fds.clear();
+    s.counter_tids = tids;
+
+#if defined(__linux__)
+    const uint64_t configs[kCounters] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                         PERF_COUNT_HW_CACHE_MISSES};
+    for (int tid : tids) {
+        for (uint64_t config : configs) {
+            int fd = open_counter(tid, config);
+            if (fd < 0) {
+                s.counter_error = std::string("perf_event_open failed: ") + std::strerror(errno);
+                return;
+            }
+            s.counter_fds.push_back(fd);
+        }
+    }
+#else
+    s.counter_error = "perf_event_open is Linux only";
+#endif
+}
+
+// Sums of each counter over the pool's threads
+bool read_counters(uint64_t out[kCounters]) {
+    ProfilerState& s = state();
+    std::fill(out, out + kCounters, 0);
+    if (!s.counter_error.empty() || s.counter_fds.empty()) return false;
+    for (size_t i = 0; i < s.counter_fds.size(); ++i) {
+        uint64_t value = 0;
+        if (::read(s.counter_fds[i], &value, sizeof(value)) != sizeof(value)) return false;
+        out[i % kCounters] += value;
+    }
+    return true;
+}
+
+std::string json_escape(const std::string& in) {
+    std::string out;
+    for (char c : in) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+} // namespace
+
+
+void enable_profiling(bool hardware_counters) {
+    ProfilerState& s = state();
+    s.enabled = true;
+    s.hardware_counters = hardware_counters;
+}
+
+bool profiling_enabled() {
+    return state().enabled;
+}
+
+void record_phase(const PhaseRecord& record) {
+    ProfilerState& s = state();
+    if (!s.enabled) return;
+    std::lock_guard<std::mutex> lock(s.m);
+
+    // One entry per phase name, so a long-running server that repeats the
+    // same phases keeps a fixed-size profile
+    auto it = std::find_if(s.phases.begin(), s.phases.end(),
+                           [&](const PhaseRecord& p) { return p.name == record.name; });
+    if (it == s.phases.end()) {
+        s.phases.push_back(record);
+        s.phases.back().max_wall_ms = record.wall_ms;
+        return;
+    }
+
+    PhaseRecord& p = *it;
+    p.calls += record.calls;
+    p.wall_ms += record.wall_ms;
+    p.max_wall_ms = std::max(p.max_wall_ms, record.wall_ms);
+    p.rows_in += record.rows_in;
+    p.rows_out += record.rows_out;
+    p.bytes += record.bytes;
+    if (p.thread_busy_ms.size() < record.thread_busy_ms.size())
+        p.thread_busy_ms.resize(record.thread_busy_ms.size(), 0.0);
+    for (size_t w = 0; w < record.thread_busy_ms.size(); ++w)
+        p.thread_busy_ms[w] += record.thread_busy_ms[w];
+    p.has_counters = p.has_counters && record.has_counters;
+    p.cycles += record.cycles;
+    p.instructions += record.instructions;
+    p.llc_misses += record.llc_misses;
+}
+
+std::vector<PhaseRecord> recorded_phases() {
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.m);
+    return s.phases;
+}
+
+void clear_recorded_phases() {
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.m);
+    s.phases.clear();
+}
+
+
+PhaseTimer::PhaseTimer(const char* name, ThreadPool& pool)
+    : active_(profiling_enabled()), pool_(pool) {
+    if (!active_) return;
+    record_.name = name;
+    ensure_counters(pool_);
+    for (int w = 0; w < pool_.size(); ++w)
+        start_busy_.push_back(pool_.busy_ns(w));
+    read_counters(start_counters_);
+    start_ns_ = now_ns();
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (!active_) return;
+    record_.wall_ms = (now_ns() - start_ns_) / 1e6;
+
+    uint64_t end_counters[kCounters];
+    if (read_counters(end_counters)) {
+        record_.has_counters = true;
+        record_.cycles = end_counters[0] - start_counters_[0];
+        record_.instructions = end_counters[1] - start_counters_[1];
+        record_.llc_misses = end_counters[2] - start_counters_[2];
+    }
+
+    for (int w = 0; w < pool_.size() && w < static_cast<int>(start_busy_.size()); ++w)
+        record_.thread_busy_ms.push_back((pool_.busy_ns(w) - start_busy_[w]) / 1e6);
+
+    record_phase(record_);
+}
+
+
+bool write_profile_report(const std::string& path) {
+    ProfilerState& s = state();
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    std::lock_guard<std::mutex> lock(s.m);
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"hardware_counters\": ";
+    if (!s.hardware_counters)
+        out << "\"off\"";
+    else if (!s.counter_error.empty())
+        out << "\"" << json_escape(s.counter_error) << "\"";
+    else
+        out << "\"on\"";
+    out << ",\n  \"phases\": [";
+
+    for (size_t i = 0; i < s.phases.size(); ++i) {
+        const PhaseRecord& p = s.phases[i];
+        out << (i ? "," : "") << "\n    {\"name\": \"" << json_escape(p.name) << "\""
+            << ", \"calls\": " << p.calls
+            << ", \"wall_ms\": " << p.wall_ms
+            << ", \"max_wall_ms\": " << p.max_wall_ms
+            << ", \"rows_in\": " << p.rows_in
+            << ", \"rows_out\": " << p.rows_out
+            << ", \"bytes\": " << p.bytes;
+
+        if (!p.thread_busy_ms.empty()) {
+            double max_ms = 0.0, sum_ms = 0.0;
+            out << ", \"thread_busy_ms\": [";
+            for (size_t w = 0; w < p.thread_busy_ms.size(); ++w) {
+                out << (w ? ", " : "") << p.thread_busy_ms[w];
+                max_ms = std::max(max_ms, p.thread_busy_ms[w]);
+                sum_ms += p.thread_busy_ms[w];
+            }
+            double mean_ms = sum_ms / p.thread_busy_ms.size();
+            // max / mean busy time: 1.0 is a perfectly even split
+            out << "], \"skew\": " << (mean_ms > 0 ? max_ms / mean_ms : 1.0);
+        }
+
+        if (p.has_counters) {
+            out << ", \"cycles\": " << p.cycles
+                << ", \"instructions\": " << p.instructions
+                << ", \"llc_misses\": " << p.llc_misses
+                << ", \"ipc\": " << (p.cycles ? static_cast<double>(p.instructions) / p.cycles : 0.0);
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
@@ -8,17 +8,35 @@
 #include <future> 
 #include <unordered_map>
 #include <iomanip> 
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <stdexcept>
+#include <sys/stat.h>
 #include "tables_soa.hpp"
+#include "mapped_file.hpp"
+#include "column_cache.hpp"
+#include "dense_index.hpp"
+#include "key_bitmap.hpp"
+#include "nation_accumulator.hpp"
+#include "thread_pool.hpp"
+#include "probe_kernels.hpp"
+#include "profiler.hpp"
+#include "numa.hpp"
 
 Config g_config;
 
 
 // Function to parse command line arguments
 bool parseArgs(int argc, char* argv[], std::string& r_name, std::string& start_date, std::string& end_date, int& num_threads, std::string& table_path, std::string& result_path) {
-    if (argc != 13) { // Expecting 6 key-value pairs + program name
-        std::cerr << "Usage: " << argv[0] << " --r_name <region_name> --start_date <date> --end_date <date> --threads <num_threads> --table_path <path> --result_path <path>" << std::endl;
+    auto usage = [&]() {
+        std::cerr << "Usage: " << argv[0] << " --r_name <region_name> --start_date <date> --end_date <date> --threads <num_threads> --table_path <path> --result_path <path> [--load_mode mmap|stream] [--cache on|off] [--stream on|off] [--join_index auto|dense|hash] [--simd on|off] [--compress on|off] [--report <json_path>] [--perf on|off] [--numa on|off] [--huge_pages off|thp|explicit]" << std::endl;
+        std::cerr << "       " << argv[0] << " --serve stdin|<socket_path> --threads <num_threads> --table_path <path> [options]" << std::endl;
+        std::cerr << "       " << argv[0] << " --batch <file> --threads <num_threads> --table_path <path> --result_path <path> [options]" << std::endl;
         return false;
-    }
+    };
+    if (argc % 2 == 0) // key-value pairs + program name
+        return usage();
 
     for (int i = 1; i < argc; i += 2) {
         std::string arg = argv[i];
@@ -44,33 +62,127 @@ bool parseArgs(int argc, char* argv[], std::string& r_name, std::string& start_d
             table_path = argv[i + 1];
         } else if (arg == "--result_path") {
             result_path = argv[i + 1];
+        } else if (arg == "--load_mode") {
+            std::string mode = argv[i + 1];
+            if (mode == "mmap") {
+                g_config.load_mode = LoadMode::Mmap;
+            } else if (mode == "stream") {
+                g_config.load_mode = LoadMode::Stream;
+            } else {
+                std::cerr << "Invalid value for --load_mode: " << mode << std::endl;
+                return false;
+            }
+        } else if (arg == "--cache") {
+            std::string value = argv[i + 1];
+            if (value != "on" && value != "off") {
+                std::cerr << "Invalid value for --cache: " << value << std::endl;
+                return false;
+            }
+            g_config.use_cache = (value == "on");
+        } else if (arg == "--stream") {
+            std::string value = argv[i + 1];
+            if (value != "on" && value != "off") {
+                std::cerr << "Invalid value for --stream: " << value << std::endl;
+                return false;
+            }
+            g_config.stream_lineitem = (value == "on");
+        } else if (arg == "--join_index") {
+            std::string value = argv[i + 1];
+            if (value == "auto") {
+                g_config.join_index = JoinIndexMode::Auto;
+            } else if (value == "dense") {
+                g_config.join_index = JoinIndexMode::Dense;
+            } else if (value == "hash") {
+                g_config.join_index = JoinIndexMode::Hash;
+            } else {
+                std::cerr << "Invalid value for --join_index: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--compress") {
+            std::string value = argv[i + 1];
+            if (value != "on" && value != "off") {
+                std::cerr << "Invalid value for --compress: " << value << std::endl;
+                return false;
+            }
+            g_config.compress_lineitem = (value == "on");
+        } else if (arg == "--batch") {
+            g_config.batch_file = argv[i + 1];
+        } else if (arg == "--serve") {
+            g_config.serve = argv[i + 1];
+        } else if (arg == "--simd") {
+            std::string value = argv[i + 1];
+            if (value != "on" && value != "off") {
+                std::cerr << "Invalid value for --simd: " << value << std::endl;
+                return false;
+            }
+            g_config.simd_probe = (value == "on");
+        } else if (arg == "--report") {
+            g_config.report_path = argv[i + 1];
+        } else if (arg == "--perf") {
+            std::string value = argv[i + 1];
+            if (value != "on" && value != "off") {
+                std::cerr << "Invalid value for --perf: " << value << std::endl;
+                return false;
+            }
+            g_config.perf_counters = (value == "on");
+        } else if (arg == "--numa") {
+            std::string value = argv[i + 1];
+            if (value != "on" && value != "off") {
+                std::cerr << "Invalid value for --numa: " << value << std::endl;
+                return false;
+            }
+            g_config.numa = (value == "on");
+        } else if (arg == "--huge_pages") {
+            std::string value = argv[i + 1];
+            if (value == "off") {
+                set_column_huge_pages(HugePageMode::Off);
+            } else if (value == "thp") {
+                set_column_huge_pages(HugePageMode::Thp);
+            } else if (value == "explicit") {
+                set_column_huge_pages(HugePageMode::Explicit);
+            } else {
+                std::cerr << "Invalid value for --huge_pages: " << value << std::endl;
+                return false;
+            }
         } else {
             std::cerr << "Unknown argument: " << arg << std::endl;
             return false;
         }
     }
+
+    // Server mode takes the query parameters per request and batch mode
+    // from the batch file instead
+    if (table_path.empty() || num_threads < 1)
+        return usage();
+    if (g_config.serve.empty() && result_path.empty())
+        return usage();
+    if (g_config.serve.empty() && g_config.batch_file.empty() &&
+        (r_name.empty() || start_date.empty() || end_date.empty()))
+        return usage();
     return true;
 }
 
 
 // // Function to read TPCH data from the specified path
 
+// Parses the lines whose first byte lies in [start, end). A chunk that starts
+// mid-line leaves that line to the previous chunk.
 void readChunk(const std::string &file_path,
                long start,
                long end,
                tables* out)
 {
     std::ifstream file(file_path, std::ios::binary);
-    file.seekg(start);
-
     std::string line;
 
-    if (start != 0)
+    if (start != 0) {
+        file.seekg(start - 1);
         std::getline(file, line);   // skip partial line
+    }
 
     long pos = file.tellg();
 
-    while (std::getline(file, line)) {
+    while (pos != -1 && pos < end && std::getline(file, line)) {
         try {
             out->insert_line(line);
         } catch (const std::exception& e) {
@@ -81,66 +193,230 @@ void readChunk(const std::string &file_path,
         }
 
         pos = file.tellg();
-        if (pos == -1 || pos >= end)
-            break;
     }
 }
 
 
-void load_data_multithreaded(
-    const std::string& file_path,
-    tables& output,
-    int num_threads)
+// Number of rows whose first byte lies in [start, end) of a mapped file:
+// the line starting at 0, plus every line that follows a '\n' at a position
+// in [start - 1, end - 1).
+size_t countChunkRows(const char* data,
+                      size_t start,
+                      size_t end)
 {
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << file_path << std::endl;
-        return;
+    if (start >= end) return 0;
+    size_t lo = start == 0 ? 0 : start - 1;
+    size_t hi = end - 1;
+    size_t rows = (start == 0) ? 1 : 0;
+    if (lo < hi)
+        rows += static_cast<size_t>(std::count(data + lo, data + hi, '\n'));
+    return rows;
+}
+
+
+// Parses the rows whose first byte lies in [start, end) of a mapped file
+// into out, starting at slot first_row. A chunk that starts mid-line leaves
+// that line to the previous chunk. Returns the number of rows written.
+size_t readChunkMapped(const char* data,
+                       size_t size,
+                       size_t start,
+                       size_t end,
+                       tables* out,
+                       size_t first_row)
+{
+    const char* file_end = data + size;
+    const char* p = data + start;
+    const char* stop = data + end;
+
+    if (start != 0)
+        p = tbl::next_line(p - 1, file_end);
+
+    size_t row = first_row;
+    while (p < stop) {
+        p = out->insert_row(p, file_end, row++);
     }
+    return row - first_row;
+}
 
-    file.seekg(0, std::ios::end);
-    long fileSize = file.tellg();
-    file.close();
 
-    long chunkSize = fileSize / num_threads;
+namespace {
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Per-file state of one load wave
+struct PendingLoad {
+    MappedFile mapped;
+    long file_size = 0;
+    std::vector<std::unique_ptr<tables>> chunks;   // stream mode only
+    std::vector<size_t> chunk_rows;
+    std::vector<size_t> chunk_first_row;
+    std::atomic<int64_t> first_start_ns{INT64_MAX};
+    std::atomic<int64_t> last_end_ns{0};
+};
+
+// Most rows `bytes` of a table's .tbl text can hold: every row has at least
+// a one-character value and a '|' for each field up to its last parsed one
+size_t chunk_row_bound(const tables& table, size_t bytes) {
+    std::vector<int> cols = table.columns();
+    size_t fields = cols.empty() ? 1 : static_cast<size_t>(*std::max_element(cols.begin(), cols.end())) + 1;
+    return bytes / (2 * fields) + 1;
+}
+
+void atomic_min(std::atomic<int64_t>& a, int64_t v) {
+    int64_t cur = a.load(std::memory_order_relaxed);
+    while (v < cur && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+}
+
+void atomic_max(std::atomic<int64_t>& a, int64_t v) {
+    int64_t cur = a.load(std::memory_order_relaxed);
+    while (v > cur && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+}
+
+} // namespace
 
-    std::vector<std::unique_ptr<tables>> thread_data;
-    thread_data.reserve(num_threads);
 
-    for (int i = 0; i < num_threads; i++)
-        thread_data.push_back(output.create_empty());
+bool load_tables_concurrently(std::vector<LoadJob>& jobs, int num_threads, LoadMode mode)
+{
+    const long chunkSize = static_cast<long>(kFileMorsel);
+    std::vector<std::unique_ptr<PendingLoad>> pending;
+    pending.reserve(jobs.size());
+
+    // (job, chunk) pairs of the whole wave; a file gets one task per 1 MB
+    std::vector<std::pair<size_t, size_t>> tasks;
 
-    std::vector<std::thread> threads;
-    threads.reserve(num_threads);
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        pending.push_back(std::make_unique<PendingLoad>());
+        PendingLoad& load = *pending.back();
 
-    for (int t = 0; t < num_threads; ++t) {
-        long start = t * chunkSize;
-        long end   = (t == num_threads - 1) ? fileSize : start + chunkSize;
+        if (mode == LoadMode::Mmap) {
+            if (!load.mapped.open(jobs[j].file_path)) {
+                std::cerr << "Failed to open file: " << jobs[j].file_path << std::endl;
+                return false;
+            }
+            load.file_size = static_cast<long>(load.mapped.size());
+        } else {
+            std::ifstream file(jobs[j].file_path, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "Failed to open file: " << jobs[j].file_path << std::endl;
+                return false;
+            }
+
+            file.seekg(0, std::ios::end);
+            load.file_size = file.tellg();
+            file.close();
+        }
 
-        threads.emplace_back(
-            readChunk,
-            std::ref(file_path),
-            start,
-            end,
-            thread_data[t].get()
-        );
+        size_t num_chunks = load.file_size > 0
+            ? static_cast<size_t>((load.file_size + chunkSize - 1) / chunkSize) : 0;
+        for (size_t c = 0; c < num_chunks; ++c)
+            tasks.emplace_back(j, c);
+        load.chunk_rows.assign(num_chunks, 0);
+        if (mode == LoadMode::Stream) {
+            // Chunk tables are reserved for the most rows a chunk can hold,
+            // so push_back never reallocates; unused capacity is never touched
+            const size_t rows_bound = chunk_row_bound(*jobs[j].output, static_cast<size_t>(chunkSize));
+            for (size_t c = 0; c < num_chunks; ++c) {
+                load.chunks.push_back(jobs[j].output->create_empty());
+                load.chunks.back()->reserve(rows_bound);
+            }
+        }
+        jobs[j].bytes = static_cast<size_t>(load.file_size);
     }
 
-    for (auto& th : threads)
-        th.join();
+    ThreadPool& pool = shared_pool(num_threads);
+    auto chunk_range = [&](const PendingLoad& load, size_t c, long& start, long& end) {
+        start = static_cast<long>(c) * chunkSize;
+        end   = std::min(start + chunkSize, load.file_size);
+    };
+
+    if (mode == LoadMode::Mmap) {
+        // Pass 1: count the rows of every chunk, so each table's columns are
+        // sized once and every chunk knows the slice it owns
+        pool.run(tasks.size(), [&](size_t t, int) {
+            PendingLoad& load = *pending[tasks[t].first];
+            size_t c = tasks[t].second;
+            long start, end;
+            chunk_range(load, c, start, end);
+            load.chunk_rows[c] = countChunkRows(load.mapped.data(),
+                                                static_cast<size_t>(start), static_cast<size_t>(end));
+        });
+
+        for (size_t j = 0; j < jobs.size(); ++j) {
+            PendingLoad& load = *pending[j];
+            size_t row = static_cast<size_t>(jobs[j].output->size());
+            load.chunk_first_row.resize(load.chunk_rows.size());
+            for (size_t c = 0; c < load.chunk_rows.size(); ++c) {
+                load.chunk_first_row[c] = row;
+                row += load.chunk_rows[c];
+            }
+            jobs[j].output->resize(row);
+        }
+    }
 
-    // std::cout << "All threads completed loading data.\n";
+    // Pass 2: parse. Mapped chunks write straight into their slice of the
+    // final columns; streamed chunks fill a chunk-local table
+    pool.run(tasks.size(), [&](size_t t, int) {
+        PendingLoad& load = *pending[tasks[t].first];
+        size_t c = tasks[t].second;
+        long start, end;
+        chunk_range(load, c, start, end);
+
+        atomic_min(load.first_start_ns, now_ns());
+        if (mode == LoadMode::Mmap) {
+            size_t rows = readChunkMapped(load.mapped.data(), load.mapped.size(),
+                                          static_cast<size_t>(start), static_cast<size_t>(end),
+                                          jobs[tasks[t].first].output, load.chunk_first_row[c]);
+            if (rows != load.chunk_rows[c])
+                throw std::runtime_error("row count mismatch in " + jobs[tasks[t].first].file_path);
+        } else
+            readChunk(jobs[tasks[t].first].file_path, start, end, load.chunks[c].get());
+        atomic_max(load.last_end_ns, now_ns());
+    });
 
     // -------- Merge ----------
-    for (int t = 0; t < num_threads; ++t)
-        output.merge_from(*thread_data[t]);
+    // Only the stream loader has chunk-local tables left to merge: one task
+    // per table, chunks in file order, so rows keep their .tbl order
+    if (mode == LoadMode::Stream) {
+        pool.run(jobs.size(), [&](size_t j, int) {
+            size_t rows = static_cast<size_t>(jobs[j].output->size());
+            for (auto& chunk : pending[j]->chunks)
+                rows += static_cast<size_t>(chunk->size());
+            jobs[j].output->reserve(rows);
+            for (auto& chunk : pending[j]->chunks)
+                jobs[j].output->merge_from(*chunk);
+            pending[j]->chunks.clear();
+        });
+    }
 
-    // std::cout << "Merged table successfully.\n";
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        const PendingLoad& load = *pending[j];
+        int64_t elapsed = load.last_end_ns.load() - load.first_start_ns.load();
+        jobs[j].seconds = elapsed > 0 ? elapsed / 1e9 : 0.0;
+    }
+    return true;
 }
 
 
-// Updated readTPCHData to use multithreaded loading
+void load_data_multithreaded(
+    const std::string& file_path,
+    tables& output,
+    int num_threads,
+    LoadMode mode)
+{
+    std::vector<LoadJob> jobs(1);
+    jobs[0].name = file_path;
+    jobs[0].file_path = file_path;
+    jobs[0].output = &output;
+    load_tables_concurrently(jobs, num_threads, mode);
+}
+
 
+// Reads all six tables. Tables with a valid column cache are read from it;
+// the rest are parsed together in one wave on the shared pool, so the small
+// tables overlap with lineitem instead of each taking a turn.
 bool readTPCHData(const std::string& table_path,
                   CustomerSOA& customer_data,
                   OrdersSOA& orders_data,
@@ -151,26 +427,106 @@ bool readTPCHData(const std::string& table_path,
 {
 try {
         int num_threads = g_config.num_threads;
-        // int num_threads = 4;
         std::cout <<"Using "<<num_threads<<" threads to load data."<<std::endl;
 
-        load_data_multithreaded(table_path + "\\" +"customer.tbl", customer_data, num_threads);
-        std::cout << "Loaded " << customer_data.size() << " customer records." << std::endl;
-
-        load_data_multithreaded(table_path + "\\" + "orders.tbl", orders_data, num_threads);
-        std::cout << "Loaded " << orders_data.size() << " orders records." << std::endl;
-
-        load_data_multithreaded(table_path + "\\" + "lineitem.tbl", lineitem_data, num_threads);
-        std::cout << "Loaded " << lineitem_data.size() << " lineitem records." << std::endl;
-
-        load_data_multithreaded(table_path + "\\" + "supplier.tbl", supplier_data, num_threads);
-        std::cout << "Loaded " << supplier_data.size() << " supplier records." << std::endl;
-
-        load_data_multithreaded(table_path + "\\" + "nation.tbl", nation_data, num_threads);
-        std::cout << "Loaded " << nation_data.size() << " nation records." << std::endl;
+        const std::pair<const char*, tables*> all_tables[] = {
+            {"customer", &customer_data}, {"orders", &orders_data},
+            {"lineitem", &lineitem_data}, {"supplier", &supplier_data},
+            {"nation", &nation_data},     {"region", &region_data},
+        };
+
+        // Streamed lineitem stays on disk; compressed lineitem is loaded by
+        // loadTPCHData a segment at a time
+        const bool skip_lineitem = g_config.stream_lineitem || g_config.compress_lineitem;
+        std::vector<LoadJob> jobs;
+        for (const auto& t : all_tables) {
+            if (t.second == &lineitem_data && skip_lineitem) {
+                if (g_config.stream_lineitem)
+                    std::cout << "lineitem will be streamed during the query." << std::endl;
+                continue;
+            }
+            std::string path = table_path + "\\" + t.first + ".tbl";
+            auto cache_t0 = std::chrono::steady_clock::now();
+            if (g_config.use_cache && load_cached_table(path, *t.second)) {
+                std::cout << "Loaded " << t.second->size() << " " << t.first
+                          << " records from cache." << std::endl;
+
+                PhaseRecord cached_phase;
+                cached_phase.name = std::string("load.") + t.first;
+                cached_phase.wall_ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - cache_t0).count();
+                cached_phase.rows_in = cached_phase.rows_out = t.second->size();
+                struct stat st;
+                if (::stat(cache_path_for(path).c_str(), &st) == 0)
+                    cached_phase.bytes = st.st_size;
+                record_phase(cached_phase);
+                continue;
+            }
+            LoadJob job;
+            job.name = t.first;
+            job.file_path = path;
+            job.output = t.second;
+            jobs.push_back(job);
+        }
 
-        load_data_multithreaded(table_path + "\\" + "region.tbl", region_data, num_threads);
-        std::cout << "Loaded " << region_data.size() << " region records." << std::endl;
+        ThreadPool& pool = shared_pool(num_threads);
+        auto t0 = std::chrono::steady_clock::now();
+        {
+            PhaseTimer phase("load", pool);
+            if (!load_tables_concurrently(jobs, num_threads, g_config.load_mode))
+                return false;
+            size_t rows = 0, bytes = 0;
+            for (const auto& job : jobs) {
+                rows += job.output->size();
+                bytes += job.bytes;
+            }
+            phase.rows(rows, rows);
+            phase.bytes(bytes);
+        }
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        size_t total_bytes = 0;
+        std::cout << std::fixed << std::setprecision(1);
+        for (const auto& job : jobs) {
+            double mb = job.bytes / (1024.0 * 1024.0);
+            std::cout << "Loaded " << job.output->size() << " " << job.name << " records ("
+                      << mb << " MB, " << (job.seconds > 0 ? mb / job.seconds : 0.0) << " MB/s)."
+                      << std::endl;
+            total_bytes += job.bytes;
+
+            // A table's share of the wave, first morsel start to last morsel end
+            PhaseRecord table_phase;
+            table_phase.name = "load." + job.name;
+            table_phase.wall_ms = job.seconds * 1000.0;
+            table_phase.rows_in = table_phase.rows_out = job.output->size();
+            table_phase.bytes = job.bytes;
+            record_phase(table_phase);
+
+            if (g_config.use_cache && !save_cached_table(job.file_path, *job.output))
+                std::cerr << "Could not write column cache for " << job.file_path << std::endl;
+        }
+        if (!jobs.empty()) {
+            double mb = total_bytes / (1024.0 * 1024.0);
+            std::cout << "Parsed " << mb << " MB in " << wall * 1000.0 << " ms ("
+                      << (wall > 0 ? mb / wall : 0.0) << " MB/s aggregate)." << std::endl;
+        }
+        static const char* const kHugePageModes[] = {"off", "thp", "explicit"};
+        std::cout << "Column storage: " << mapped_column_total() / (1024.0 * 1024.0) << " MB mapped, huge pages "
+                  << kHugePageModes[static_cast<int>(column_huge_pages())];
+        if (column_huge_pages() == HugePageMode::Explicit)
+            std::cout << " (" << mapped_column_hugetlb() / (1024.0 * 1024.0) << " MB from the hugetlb pool)";
+        std::cout << "." << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+
+        // Zone maps for the query phases to skip morsels with
+        PhaseTimer phase("load.zone_maps", pool);
+        orders_data.o_orderdate_zones.build(orders_data.o_orderdate, pool);
+        if (!skip_lineitem)
+            lineitem_data.l_orderkey_zones.build(lineitem_data.l_orderkey, pool);
+        size_t zone_rows = orders_data.size() + (skip_lineitem ? 0 : lineitem_data.size());
+        phase.rows(zone_rows, zone_rows);
+        phase.bytes(zone_rows * sizeof(int));
     
         return true;
     } catch (const std::exception& e) {
@@ -179,88 +535,351 @@ try {
     }
 }
 
-// QUERY 5 WORKER FUNCTIONS
+// QUERY 5 PLAN
+//
+// Q5 as a composition of the operators in operators.hpp:
+//   supplier, customer: scan + filter on the region's nations -> JoinTable
+//   orders:             scan + date filter + probe customer   -> JoinTable
+//   lineitem:           scan + semi-join both key bitmaps + probe orders
+//                       + probe supplier on (suppkey, nation)
+//                       + DenseAggregate by nation
+
+// Probes rows [start, end) of lineitem columns against a finished build side.
+// When both join tables are dense the probe-and-aggregate steps run fused
+// in the best SIMD kernel the CPU supports, unless --simd off.
+void probe_lineitem(
+    size_t start,
+    size_t end,
+    const LineItemColumns& cols,
+    const Q5BuildSide& build,
+    NationAccumulator& local_result
+){
+    static const ProbeKernel kernel = select_probe_kernel();
+
+    const ops::JoinTable<int8_t>& order_table = build.orders->table;
+    const ops::JoinTable<int8_t>& supp_table = *build.suppliers;
+
+    if (kernel && g_config.simd_probe && order_table.dense() && supp_table.dense()) {
+        const NationIndex& orders = order_table.dense_index();
+        const NationIndex& suppliers = supp_table.dense_index();
+        DenseProbeTables tables{orders.data(), orders.capacity(),
+                                suppliers.data(), suppliers.capacity(),
+                                build.region_nations};
+        kernel(cols, start, end, tables, local_result);
+        return;
+    }
+
+    ops::Selection sel;
+    int8_t nations[ops::kBatchRows];
+    auto revenue = [&](size_t row) {
+        return discounted_revenue(cols.extendedprice[row], cols.discount[row]);
+    };
+
+    order_table.visit([&](const auto& orders) {
+        supp_table.visit([&](const auto& suppliers) {
+            ops::batches(start, end, [&](size_t b, size_t e) {
+                ops::semi_join(order_table.filter(), cols.orderkey, b, e, sel);
+                ops::semi_join(supp_table.filter(), cols.suppkey, sel);
+                ops::probe(orders, cols.orderkey, sel, nations);
+                ops::probe_equal(suppliers, cols.suppkey, sel, nations);
+                ops::aggregate(sel, nations, revenue, local_result);
+            });
+        });
+    });
+}
 
-void lineitem_worker(
+void probe_lineitem(
     size_t start,
     size_t end,
     const LineItemSOA& lineitem,
-    const std::unordered_map<int,int>& order_to_nation,
-    const std::unordered_map<int,int>& supp_to_nation,
-    const std::unordered_map<int,std::string>& nationkey_to_name,
-    std::unordered_map<std::string,double>& local_result
+    const Q5BuildSide& build,
+    NationAccumulator& local_result
 ){
-    for(size_t i=start;i<end;++i){
-        int order = lineitem.l_orderkey[i];
-        int supp  = lineitem.l_suppkey[i];
+    LineItemColumns cols{lineitem.l_orderkey.data(), lineitem.l_suppkey.data(),
+                         lineitem.l_extendedprice.data(), lineitem.l_discount.data()};
+    probe_lineitem(start, end, cols, build, local_result);
+}
 
-        auto oit = order_to_nation.find(order);
-        if(oit == order_to_nation.end()) continue;
+// Compressed lineitem: each block overlapping rows [start, end) is decoded
+// into the caller's buffer, unless it already holds that block, and the
+// overlapping rows are probed from there
+void probe_lineitem(
+    size_t start,
+    size_t end,
+    const PackedLineItemSOA& lineitem,
+    const Q5BuildSide& build,
+    PackedProbeBuffer& buffer,
+    NationAccumulator& local_result
+){
+    PackedLineItemSOA::Block& block = *buffer.block;
+    const LineItemColumns cols{block.l_orderkey, block.l_suppkey, block.l_extendedprice, block.l_discount};
+    for (size_t b = start / kPackBlock; b * kPackBlock < end; ++b) {
+        if (buffer.index != b) {
+            lineitem.decode_block(b, block);
+            buffer.index = b;
+        }
+        const size_t base = b * kPackBlock;
+        const size_t first = std::max(start, base) - base;
+        const size_t last = std::min(end, base + lineitem.block_rows(b)) - base;
+        probe_lineitem(first, last, cols, build, local_result);
+    }
+}
 
-        auto sit = supp_to_nation.find(supp);
-        if(sit == supp_to_nation.end()) continue;
 
-        if(oit->second != sit->second) continue;
+// key -> nation for the rows of a table whose nation is in the region:
+// filter on the nation, then emit the rows that are left
+std::shared_ptr<ops::JoinTable<int8_t>> build_region_table(
+    ThreadPool& pool,
+    const Column<int>& keys,
+    const Column<int>& nationkeys,
+    NationSet region_nations
+){
+    auto table = std::make_shared<ops::JoinTable<int8_t>>();
+    const int max = max_key(keys);
+    table->build(pool, keys.size(), max, ops::use_dense_index(ops::JoinIndexMode::Auto, max, keys.size()),
+                [&](size_t start, size_t end, auto&& emit) {
+        ops::Selection sel;
+        ops::batches(start, end, [&](size_t b, size_t e) {
+            ops::filter(b, e, [&](size_t row) { return nation_in_set(region_nations, nationkeys[row]); }, sel);
+            for (uint32_t j = 0; j < sel.count; ++j) {
+                size_t row = sel.row(j);
+                emit(keys[row], static_cast<int8_t>(nationkeys[row]));
+            }
+        });
+    });
+    return table;
+}
 
-        double price = lineitem.l_extendedprice[i];
-        double disc  = lineitem.l_discount[i];
-        double revenue = price*(1.0 - disc);
 
-        const std::string& name = nationkey_to_name.at(oit->second);
-        local_result[name] += revenue;
-    }
+// orders filtered by date and joined with the region's customers: each
+// batch is filtered on the date, probed against the customers, and the
+// orders left are emitted with their customer's nation. Morsels whose dates
+// all fall outside the range are skipped by the zone map.
+std::shared_ptr<Q5OrdersSide> orders_filter(
+    ThreadPool& pool,
+    const OrdersSOA& orders_data,
+    const ops::JoinTable<int8_t>& customers,
+    int start_day,
+    int end_day
+){
+    auto side = std::make_shared<Q5OrdersSide>();
+    const ZoneMap& zones = orders_data.o_orderdate_zones;
+    const bool use_zones = zones.covers(orders_data.size());
+    std::atomic<size_t> skipped{0};
+    auto skip_morsel = [&](size_t start, size_t end) {
+        if (!use_zones || zones.may_overlap(start, start_day, end_day - 1))
+            return false;
+        skipped.fetch_add(end - start, std::memory_order_relaxed);
+        return true;
+    };
+
+    // start_day <= date < end_day as a single unsigned compare
+    const unsigned span = static_cast<unsigned>(end_day - start_day);
+    const int* dates = orders_data.o_orderdate.data();
+    const int* custkeys = orders_data.o_custkey.data();
+    const int* orderkeys = orders_data.o_orderkey.data();
+
+    const int max_orderkey = max_key(orders_data.o_orderkey);
+    const bool dense = ops::use_dense_index(g_config.join_index, max_orderkey, orders_data.size());
+
+    customers.visit([&](const auto& cust_to_nation) {
+        side->table.build(pool, orders_data.size(), max_orderkey, dense,
+                           [&](size_t start, size_t end, auto&& emit) {
+            ops::Selection sel;
+            int8_t nations[ops::kBatchRows];
+            ops::batches(start, end, [&](size_t b, size_t e) {
+                ops::filter(b, e, [&](size_t row) { return static_cast<unsigned>(dates[row] - start_day) < span; },
+                            sel);
+                ops::probe(cust_to_nation, custkeys, sel, nations);
+                for (uint32_t j = 0; j < sel.count; ++j)
+                    emit(orderkeys[sel.row(j)], nations[j]);
+            });
+        }, skip_morsel);
+    });
+
+    side->rows = orders_data.size();
+    side->skipped = skipped.load();
+    return side;
 }
 
 
-void orders_worker(
-    size_t start,
-    size_t end,
-    const OrdersSOA& orders,
-    const std::unordered_map<int,int>& cust_to_nation,
-    const std::string& start_date,
-    const std::string& end_date,
-    std::unordered_map<int,int>& local_map
-){
-    for(size_t i=start;i<end;++i){
+// Prints why a query failed and hands the reason to a caller that asked for it
+bool fail(std::string* error, const std::string& message)
+{
+    std::cerr << message << std::endl;
+    if (error) *error = message;
+    return false;
+}
 
-        const std::string& date = orders.o_orderdate[i];
-        if(date < start_date || date >= end_date)
-            continue;
+// Builds everything the lineitem probe needs from the five small tables
+bool buildQ5BuildSide(const std::string& r_name,
+                      const std::string& start_date,
+                      const std::string& end_date,
+                      int num_threads,
+                      const CustomerSOA& customer_data,
+                      const OrdersSOA& orders_data,
+                      const SupplierSOA& supplier_data,
+                      const NationSOA& nation_data,
+                      const RegionSOA& region_data,
+                      Q5BuildSide& build,
+                      Q5Cache* cache,
+                      std::string* error)
+{
+    // region → regionkey
+    int regionKey = -1;
+    for (size_t i = 0; i < region_data.r_name.size(); ++i) {
+        if (region_data.r_name[i] == r_name) {
+            regionKey = region_data.r_regionkey[i];
+            break;
+        }
+    }
+    if (regionKey == -1)
+        return fail(error, region_data.size() == 0 ? "No region table is loaded" : "Unknown region " + r_name);
+
+    // Dates are compared as days since the epoch, like o_orderdate
+    int start_day = 0, end_day = 0;
+    if (!tbl::parse_date(start_date, start_day) || !tbl::parse_date(end_date, end_day))
+        return fail(error, "Dates must be valid YYYY-MM-DD calendar dates");
+    if (end_day < start_day) end_day = start_day;
 
-        int cust = orders.o_custkey[i];
-        auto it = cust_to_nation.find(cust);
-        if(it == cust_to_nation.end()) continue;
+    // nationkey → nation_name 
+    auto& nationkey_to_name = build.nationkey_to_name;
+    nationkey_to_name.clear();
+    nationkey_to_name.reserve(nation_data.n_nationkey.size());
+    NationSet region_nations = 0;
 
-        local_map[orders.o_orderkey[i]] = it->second;
+    for (size_t i = 0; i < nation_data.n_nationkey.size(); ++i) {
+        if (nation_data.n_nationkey[i] < 0 || nation_data.n_nationkey[i] >= kMaxNations)
+            return fail(error, "Nation key out of range: " + std::to_string(nation_data.n_nationkey[i]));
+        if (nation_data.n_regionkey[i] == regionKey) {
+            nationkey_to_name[nation_data.n_nationkey[i]] =
+                nation_data.n_name[i];
+            region_nations |= 1u << nation_data.n_nationkey[i];
+        }
     }
-}
 
-void customer_worker(
-    size_t start,
-    size_t end,
-    const CustomerSOA& customer,
-    std::unordered_map<int,int>& local_map
-){
-    for(size_t i=start;i<end;++i){
-        local_map[customer.c_custkey[i]] = customer.c_nationkey[i];
+    // Every phase runs as 64K-row morsels on the shared pool
+    ThreadPool& pool = shared_pool(num_threads);
+
+    build.region_nations = region_nations;
+
+    // suppkey → nationkey and custkey → nationkey for the region
+    // Phases only appear in the profile when they run, not on cache hits
+    auto make_suppliers = [&]() {
+        PhaseTimer phase("q5.suppliers", pool);
+        auto table = build_region_table(pool, supplier_data.s_suppkey, supplier_data.s_nationkey, region_nations);
+        phase.rows(supplier_data.size(), table->filter().count());
+        phase.bytes(supplier_data.size() * 2 * sizeof(int));
+        return table;
+    };
+    auto make_customers = [&]() {
+        PhaseTimer phase("q5.customers", pool);
+        auto table = build_region_table(pool, customer_data.c_custkey, customer_data.c_nationkey, region_nations);
+        phase.rows(customer_data.size(), table->filter().count());
+        phase.bytes(customer_data.size() * 2 * sizeof(int));
+        return table;
+    };
+
+    // orderkey → nationkey for orders in the date range
+    std::shared_ptr<const ops::JoinTable<int8_t>> customers;
+    auto make_orders = [&]() {
+        if (!customers) customers = cache ? cache->customers.get(r_name, make_customers) : make_customers();
+        PhaseTimer phase("q5.orders", pool);
+        auto side = orders_filter(pool, orders_data, *customers, start_day, end_day);
+        phase.rows(side->rows, side->table.filter().count());
+        phase.bytes((side->rows - side->skipped) * 3 * sizeof(int));
+        return side;
+    };
+
+    if (!cache) {
+        build.suppliers = make_suppliers();
+        build.orders = make_orders();
+        return true;
     }
+
+    // Customers are only needed when the orders side is not cached
+    const std::string dates_key = r_name + "|" + std::to_string(start_day) + "|" + std::to_string(end_day);
+    build.suppliers = cache->suppliers.get(r_name, make_suppliers);
+    build.orders = cache->orders.get(dates_key, make_orders);
+    return true;
 }
 
 
-void supplier_worker(
-    size_t start,
-    size_t end,
-    const SupplierSOA& supplier,
-    const std::unordered_map<int,std::string>& nationkey_to_name,
-    std::unordered_map<int,int>& local_map
-){
-    for (size_t i = start; i < end; ++i) {
-        int nationkey = supplier.s_nationkey[i];
+// A lineitem morsel can be skipped when no qualifying order has a key in
+// its zone's orderkey range
+bool lineitem_zone_skippable(const ZoneMap& zones, size_t start, const KeyBitmap& order_filter)
+{
+    const ZoneMap::Zone* zone = zones.zone_at(start);
+    return zone && !order_filter.any_in(zone->min, zone->max);
+}
+
+// Prints the fraction of each scan the zone maps let the query skip
+void report_zone_skips(const Q5BuildSide& build, size_t lineitem_skipped, size_t lineitem_rows)
+{
+    auto percent = [](size_t part, size_t whole) {
+        return whole ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+    };
+    std::cout << std::fixed << std::setprecision(1)
+              << "Zone maps skipped " << percent(build.orders->skipped, build.orders->rows)
+              << "% of orders and " << percent(lineitem_skipped, lineitem_rows)
+              << "% of lineitem rows." << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
 
-        auto it = nationkey_to_name.find(nationkey);
-        if (it == nationkey_to_name.end()) continue;
+// Revenue per nation: one accumulator per pool worker, whichever morsels it
+// ends up running
+using Q5Aggregate = ops::DenseAggregate<NationAccumulator>;
+
+// Lineitem rows that reached the aggregate, over every worker
+uint64_t matched_rows(const std::vector<NationAccumulator>& local_results)
+{
+    uint64_t rows = 0;
+    for (const auto& local : local_results)
+        for (int n = 0; n < kMaxNations; ++n)
+            rows += static_cast<uint64_t>(local.rows[n]);
+    return rows;
+}
+
+uint64_t matched_rows(const Q5Aggregate& revenue)
+{
+    const NationAccumulator totals = revenue.result();
+    uint64_t rows = 0;
+    for (int n = 0; n < kMaxNations; ++n)
+        rows += static_cast<uint64_t>(totals.rows[n]);
+    return rows;
+}
 
-        local_map[supplier.s_suppkey[i]] = nationkey;
+// A lineitem morsel can be skipped when its zone holds no qualifying order;
+// skipped rows are counted into skipped
+auto lineitem_skip(const ZoneMap& zones, size_t rows, const Q5BuildSide& build, std::atomic<size_t>& skipped)
+{
+    const bool use_zones = zones.covers(rows);
+    const KeyBitmap& order_filter = build.orders->table.filter();
+    return [&zones, &order_filter, &skipped, use_zones](size_t start, size_t end) {
+        if (!use_zones || !lineitem_zone_skippable(zones, start, order_filter))
+            return false;
+        skipped.fetch_add(end - start, std::memory_order_relaxed);
+        return true;
+    };
+}
+
+// Merges the per-worker accumulators exactly, then resolves names and
+// converts once
+void finishQ5(ThreadPool& pool,
+              const Q5BuildSide& build,
+              const Q5Aggregate& revenue,
+              std::map<std::string, double>& results)
+{
+    PhaseTimer phase("q5.finish", pool);
+    phase.rows(revenue.size(), build.nationkey_to_name.size());
+    phase.bytes(revenue.size() * sizeof(NationAccumulator));
+
+    const NationAccumulator totals = revenue.result();
+    for (const auto& [nationkey, name] : build.nationkey_to_name) {
+        if (totals.rows[nationkey] > 0)
+            results[name] = revenue_to_double(totals.revenue[nationkey]);
     }
 }
 
@@ -276,174 +895,695 @@ bool executeQuery5(const std::string& r_name,
                    const SupplierSOA& supplier_data,
                    const NationSOA& nation_data,
                    const RegionSOA& region_data,
-                   std::map<std::string, double>& results)
-    // TODO: Implement TPCH Query 5 using multithreading
+                   std::map<std::string, double>& results,
+                   Q5Cache* cache,
+                   std::string* error)
 {
-    // region → regionkey
-    int regionKey = -1;
-    for (size_t i = 0; i < region_data.r_name.size(); ++i) {
-        if (region_data.r_name[i] == r_name) {
-            regionKey = region_data.r_regionkey[i];
-            break;
+    Q5BuildSide build;
+    if (!buildQ5BuildSide(r_name, start_date, end_date, num_threads, customer_data, orders_data,
+                          supplier_data, nation_data, region_data, build, cache, error))
+        return false;
+
+    // Multithreaded lineitem scan: semi-join, probe and aggregate per batch
+    ThreadPool& pool = shared_pool(num_threads);
+    Q5Aggregate revenue(pool.size());
+    std::atomic<size_t> skipped{0};
+    const LineItemColumns cols{lineitem_data.l_orderkey.data(), lineitem_data.l_suppkey.data(),
+                               lineitem_data.l_extendedprice.data(), lineitem_data.l_discount.data()};
+
+    {
+        PhaseTimer phase("q5.lineitem", pool);
+        ops::scan(pool, lineitem_data.size(), [&](size_t begin, size_t end, int worker) {
+            probe_lineitem(begin, end, cols, build, revenue.local(worker));
+        }, lineitem_skip(lineitem_data.l_orderkey_zones, lineitem_data.size(), build, skipped));
+        // The probe reads four columns of every row it does not skip
+        phase.rows(lineitem_data.size(), matched_rows(revenue));
+        phase.bytes((lineitem_data.size() - skipped.load()) * (2 * sizeof(int) + 2 * sizeof(Cents)));
+    }
+
+    report_zone_skips(build, skipped.load(), lineitem_data.size());
+    finishQ5(pool, build, revenue, results);
+    return true;
+}
+
+
+// Same scan over a compressed lineitem table; morsels are whole blocks
+bool executeQuery5(const std::string& r_name,
+                   const std::string& start_date,
+                   const std::string& end_date,
+                   int num_threads,
+                   const CustomerSOA& customer_data,
+                   const OrdersSOA& orders_data,
+                   const PackedLineItemSOA& lineitem_data,
+                   const SupplierSOA& supplier_data,
+                   const NationSOA& nation_data,
+                   const RegionSOA& region_data,
+                   std::map<std::string, double>& results,
+                   Q5Cache* cache,
+                   std::string* error)
+{
+    Q5BuildSide build;
+    if (!buildQ5BuildSide(r_name, start_date, end_date, num_threads, customer_data, orders_data,
+                          supplier_data, nation_data, region_data, build, cache, error))
+        return false;
+
+    ThreadPool& pool = shared_pool(num_threads);
+    Q5Aggregate revenue(pool.size());
+    std::atomic<size_t> skipped{0};
+
+    // Batches never straddle a block, so each worker decodes a block into
+    // its own buffer when the first of the block's batches reaches it
+    static_assert(kRowMorsel % kPackBlock == 0, "morsels must cover whole blocks");
+    static_assert(kPackBlock % ops::kBatchRows == 0, "blocks must hold whole batches");
+    std::vector<PackedProbeBuffer> buffers(pool.size());
+
+    {
+        PhaseTimer phase("q5.lineitem", pool);
+        ops::scan(pool, lineitem_data.size(), [&](size_t begin, size_t end, int worker) {
+            probe_lineitem(begin, end, lineitem_data, build, buffers[worker], revenue.local(worker));
+        }, lineitem_skip(lineitem_data.l_orderkey_zones, lineitem_data.size(), build, skipped));
+        // Compressed bytes, in proportion to the blocks decoded
+        const size_t rows = lineitem_data.size();
+        phase.rows(rows, matched_rows(revenue));
+        phase.bytes(rows ? static_cast<uint64_t>(static_cast<double>(lineitem_data.bytes()) *
+                                                 (rows - skipped.load()) / rows) : 0);
+    }
+
+    report_zone_skips(build, skipped.load(), lineitem_data.size());
+    finishQ5(pool, build, revenue, results);
+    return true;
+}
+
+
+// Streaming variant: lineitem.tbl is never materialized. Each 1 MB morsel
+// is parsed into its worker's reusable batch and probed right away, so
+// lineitem costs one batch per worker instead of the whole table.
+bool executeQuery5Streaming(const std::string& r_name,
+                            const std::string& start_date,
+                            const std::string& end_date,
+                            int num_threads,
+                            const std::string& lineitem_path,
+                            const CustomerSOA& customer_data,
+                            const OrdersSOA& orders_data,
+                            const SupplierSOA& supplier_data,
+                            const NationSOA& nation_data,
+                            const RegionSOA& region_data,
+                            std::map<std::string, double>& results,
+                            Q5Cache* cache,
+                      std::string* error)
+{
+    Q5BuildSide build;
+    if (!buildQ5BuildSide(r_name, start_date, end_date, num_threads, customer_data, orders_data,
+                          supplier_data, nation_data, region_data, build, cache, error))
+        return false;
+
+    MappedFile mapped;
+    if (!mapped.open(lineitem_path))
+        return fail(error, "Failed to open file: " + lineitem_path);
+
+    ThreadPool& pool = shared_pool(num_threads);
+    Q5Aggregate revenue(pool.size());
+    std::vector<LineItemSOA> batches(pool.size());
+
+    std::atomic<size_t> parsed{0};
+    try {
+        // Parsing and probing interleave per morsel, so they are one phase
+        PhaseTimer phase("q5.lineitem_stream", pool);
+        parallel_for(pool, mapped.size(), kFileMorsel,
+                     [&](size_t start, size_t end, int worker) {
+            LineItemSOA& batch = batches[worker];
+            size_t rows = countChunkRows(mapped.data(), start, end);
+            parsed.fetch_add(rows, std::memory_order_relaxed);
+            batch.resize(rows);
+            readChunkMapped(mapped.data(), mapped.size(), start, end, &batch, 0);
+
+            probe_lineitem(0, rows, batch, build, revenue.local(worker));
+
+            // Pages behind this morsel are not needed again
+            mapped.release(start, end);
+        });
+        phase.rows(parsed.load(), matched_rows(revenue));
+        phase.bytes(mapped.size());
+    } catch (const std::exception& e) {
+        return fail(error, std::string("Error streaming lineitem: ") + e.what());
+    }
+
+    report_zone_skips(build, 0, 0);
+    finishQ5(pool, build, revenue, results);
+    return true;
+}
+
+
+namespace {
+
+// Moves each worker's share of the orders and lineitem scans to its node
+// and prints where the pages ended up and the read bandwidth per node
+void place_tables_numa(TPCHData& data, ThreadPool& pool)
+{
+    const OrdersSOA& orders = data.orders;
+    const LineItemSOA& lineitem = data.lineitem;
+    const std::vector<NumaColumn> order_columns = {
+        {orders.o_orderkey.data(), sizeof(int)}, {orders.o_custkey.data(), sizeof(int)},
+        {orders.o_orderdate.data(), sizeof(int)}};
+    const std::vector<NumaColumn> lineitem_columns = {
+        {lineitem.l_orderkey.data(), sizeof(int)}, {lineitem.l_suppkey.data(), sizeof(int)},
+        {lineitem.l_extendedprice.data(), sizeof(Cents)}, {lineitem.l_discount.data(), sizeof(Cents)}};
+
+    bool ok_orders = true, ok_lineitem = true;
+    size_t placed = 0;
+    {
+        PhaseTimer phase("load.numa_place", pool);
+        placed += numa_place_columns(pool, order_columns, orders.size(), kRowMorsel, ok_orders);
+        placed += numa_place_columns(pool, lineitem_columns, lineitem.size(), kRowMorsel, ok_lineitem);
+        phase.rows(orders.size() + lineitem.size(), orders.size() + lineitem.size());
+        phase.bytes(placed);
+    }
+
+    const NumaTopology& topo = numa_topology();
+    std::cout << "NUMA: " << topo.num_nodes() << " node(s), " << pool.size() << " pinned workers";
+    if (topo.num_nodes() < 2)
+        std::cout << ", single node: nothing to place." << std::endl;
+    else if (!ok_orders || !ok_lineitem)
+        std::cout << ", mbind unavailable: columns left where they were loaded." << std::endl;
+    else
+        std::cout << ", " << placed / (1024 * 1024) << " MB placed." << std::endl;
+
+    // Measured on lineitem, or on orders when lineitem is compressed or streamed
+    const bool use_lineitem = lineitem.size() > 0;
+    const std::vector<NumaColumn>& columns = use_lineitem ? lineitem_columns : order_columns;
+    const size_t rows = use_lineitem ? lineitem.size() : orders.size();
+    const char* table = use_lineitem ? "lineitem" : "orders";
+
+    double local = numa_local_fraction(pool, columns, rows, kRowMorsel);
+    std::cout << std::fixed << std::setprecision(1);
+    if (local >= 0)
+        std::cout << "NUMA: " << 100.0 * local << "% of " << table << " pages are on their scanning node." << std::endl;
+    for (const NumaBandwidth& b : numa_measure_bandwidth(pool, columns, rows, kRowMorsel)) {
+        std::cout << "NUMA node " << b.node << ": " << b.workers << " workers, " << table << " local read "
+                  << b.local_gbs << " GB/s";
+        if (topo.num_nodes() > 1)
+            std::cout << ", remote read " << b.remote_gbs << " GB/s";
+        std::cout << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
+// Text per step of the compressed lineitem load
+constexpr size_t kPackSegmentBytes = 64 * kFileMorsel;
+
+// Loads lineitem straight into the compressed format, from its column cache
+// when there is a valid one and otherwise from lineitem.tbl. Either source
+// is read a segment at a time and each segment is packed before the next is
+// read, so the raw columns of only one segment are ever resident. Rows
+// short of a whole zone carry over into the next segment. Returns false if
+// the source cannot be read; fits is false if the data does not fit the
+// compressed format.
+bool loadPackedLineItem(const std::string& path, PackedLineItemSOA& packed, ThreadPool& pool, bool& fits)
+{
+    packed.clear();
+    fits = true;
+
+    MappedFile cache;
+    ColumnReader reader;
+    if (g_config.use_cache && open_cached_table(path, LineItemSOA(), cache, reader)) {
+        // Same column order as LineItemSOA::save_columns
+        const int* orderkey = reader.view<int>();
+        const int* suppkey = reader.view<int>();
+        const Cents* extendedprice = reader.view<Cents>();
+        const Cents* discount = reader.view<Cents>();
+        if (reader.ok()) {
+            const size_t rows = reader.rows();
+            const size_t step = kPackSegmentBytes / (2 * sizeof(int) + 2 * sizeof(Cents)) / kZoneRows * kZoneRows;
+            auto release = [&](const void* column, size_t width, size_t begin, size_t end) {
+                size_t offset = static_cast<size_t>(static_cast<const char*>(column) - cache.data());
+                cache.release(offset + begin * width, offset + end * width);
+            };
+            for (size_t begin = 0; begin < rows; begin += step) {
+                size_t end = std::min(rows, begin + step);
+                if (!packed.append(orderkey + begin, suppkey + begin, extendedprice + begin,
+                                   discount + begin, end - begin, pool)) {
+                    fits = false;
+                    return true;
+                }
+                release(orderkey, sizeof(int), begin, end);
+                release(suppkey, sizeof(int), begin, end);
+                release(extendedprice, sizeof(Cents), begin, end);
+                release(discount, sizeof(Cents), begin, end);
+            }
+            std::cout << "Loaded " << rows << " lineitem records from cache." << std::endl;
+            return true;
         }
+        packed.clear();
     }
-    if (regionKey == -1) return false;
 
-    // nationkey → nation_name 
-    std::unordered_map<int,std::string> nationkey_to_name;
-    nationkey_to_name.reserve(nation_data.n_nationkey.size());
+    MappedFile mapped;
+    if (!mapped.open(path)) {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        return false;
+    }
 
-    for (size_t i = 0; i < nation_data.n_nationkey.size(); ++i) {
-        if (nation_data.n_regionkey[i] == regionKey) {
-            nationkey_to_name[nation_data.n_nationkey[i]] =
-                nation_data.n_name[i];
+    LineItemSOA segment;
+    segment.reserve(chunk_row_bound(segment, kPackSegmentBytes) + kZoneRows);
+    const size_t morsels = (mapped.size() + kFileMorsel - 1) / kFileMorsel;
+    const size_t per_segment = kPackSegmentBytes / kFileMorsel;
+    std::vector<size_t> first_row(per_segment);
+    auto morsel_range = [&](size_t m, size_t& start, size_t& end) {
+        start = m * kFileMorsel;
+        end = std::min(start + kFileMorsel, mapped.size());
+    };
+
+    for (size_t m0 = 0; m0 < morsels; m0 += per_segment) {
+        const size_t count = std::min(per_segment, morsels - m0);
+
+        // Pass 1: rows per morsel, so each morsel parses into its own slice
+        // after the rows carried over
+        pool.run(count, [&](size_t t, int) {
+            size_t start, end;
+            morsel_range(m0 + t, start, end);
+            first_row[t] = countChunkRows(mapped.data(), start, end);
+        });
+        size_t rows = static_cast<size_t>(segment.size());
+        for (size_t t = 0; t < count; ++t) {
+            size_t morsel_rows = first_row[t];
+            first_row[t] = rows;
+            rows += morsel_rows;
+        }
+        segment.resize(rows);
+
+        // Pass 2: parse
+        pool.run(count, [&](size_t t, int) {
+            size_t start, end;
+            morsel_range(m0 + t, start, end);
+            readChunkMapped(mapped.data(), mapped.size(), start, end, &segment, first_row[t]);
+        });
+        size_t seg_start, seg_end, unused;
+        morsel_range(m0, seg_start, unused);
+        morsel_range(m0 + count - 1, unused, seg_end);
+        mapped.release(seg_start, seg_end);
+
+        // Pack whole zones; the last segment packs everything
+        const bool last = m0 + count == morsels;
+        const size_t whole = last ? rows : rows / kZoneRows * kZoneRows;
+        if (!packed.append(segment.l_orderkey.data(), segment.l_suppkey.data(),
+                           segment.l_extendedprice.data(), segment.l_discount.data(), whole, pool)) {
+            fits = false;
+            return true;
         }
+
+        // The rest moves to the front; it is shorter than a zone, so it
+        // never overlaps the packed rows it replaces
+        const size_t left = rows - whole;
+        if (whole > 0 && left > 0) {
+            std::copy(segment.l_orderkey.begin() + whole, segment.l_orderkey.end(), segment.l_orderkey.begin());
+            std::copy(segment.l_suppkey.begin() + whole, segment.l_suppkey.end(), segment.l_suppkey.begin());
+            std::copy(segment.l_extendedprice.begin() + whole, segment.l_extendedprice.end(),
+                      segment.l_extendedprice.begin());
+            std::copy(segment.l_discount.begin() + whole, segment.l_discount.end(), segment.l_discount.begin());
+        }
+        segment.resize(left);
     }
+    return true;
+}
 
-    // Multithreaded suppkey → nationkey 
-    num_threads = Config().num_threads;
-    size_t total = supplier_data.s_suppkey.size();
-    size_t chunk = total / num_threads;
+// Loads every table under path into data, which starts out empty
+bool load_all_tables(const std::string& path, TPCHData& data)
+{
+    data.table_path = path;
 
-    std::vector<std::unordered_map<int,int>> local_supp(num_threads);
-    std::vector<std::thread> threads;
+    // Workers are pinned before the load so every later phase runs pinned
+    if (g_config.numa && !numa_pin_pool(shared_pool(g_config.num_threads)))
+        std::cerr << "Could not pin every worker thread; continuing unpinned." << std::endl;
 
-    for(int t=0;t<num_threads;++t){
-        size_t s = t*chunk;
-        size_t e = (t==num_threads-1)? total : s+chunk;
+    if (!readTPCHData(path, data.customer, data.orders, data.lineitem, data.supplier,
+                      data.nation, data.region))
+        return false;
 
-        threads.emplace_back(
-            supplier_worker,
-            s, e,
-            std::cref(supplier_data),
-            std::cref(nationkey_to_name),
-            std::ref(local_supp[t])
-        );
+    // Compressed lineitem is packed while it loads; the raw columns are
+    // loaded instead only if it does not fit the compressed format
+    if (g_config.compress_lineitem && !g_config.stream_lineitem) {
+        const std::string lineitem_path = path + "\\lineitem.tbl";
+        ThreadPool& pool = shared_pool(g_config.num_threads);
+        bool fits = true;
+        {
+            PhaseTimer phase("load.compress", pool);
+            if (!loadPackedLineItem(lineitem_path, data.packed_lineitem, pool, fits))
+                return false;
+            size_t rows = data.packed_lineitem.size();
+            phase.rows(rows, rows);
+            phase.bytes(rows * (2 * sizeof(int) + 2 * sizeof(Cents)));
+        }
+
+        if (fits) {
+            size_t raw_bytes = data.packed_lineitem.size() * (2 * sizeof(int) + 2 * sizeof(Cents));
+            data.lineitem_packed = true;
+            std::cout << "Compressed lineitem: " << raw_bytes / (1024 * 1024) << " MB -> "
+                      << data.packed_lineitem.bytes() / (1024 * 1024) << " MB." << std::endl;
+        } else {
+            data.packed_lineitem.clear();
+            std::cout << "Lineitem does not fit the compressed format, scanning raw columns." << std::endl;
+            std::vector<LoadJob> jobs(1);
+            jobs[0].name = "lineitem";
+            jobs[0].file_path = lineitem_path;
+            jobs[0].output = &data.lineitem;
+            if (!load_tables_concurrently(jobs, g_config.num_threads, g_config.load_mode))
+                return false;
+            data.lineitem.l_orderkey_zones.build(data.lineitem.l_orderkey, pool);
+        }
     }
-    for(auto& th:threads) th.join();
 
-    std::unordered_map<int,int> supp_to_nation;
-    for(auto& m: local_supp)
-        supp_to_nation.insert(m.begin(), m.end());
+    // Compressed blocks and streamed lineitem are not placed; orders still is
+    if (g_config.numa)
+        place_tables_numa(data, shared_pool(g_config.num_threads));
+    return true;
+}
 
+} // namespace
 
 
-    // custkey → nationkey
+bool loadTPCHData(const std::string& table_path, TPCHData& data)
+{
+    // A reload builds a complete second copy and swaps it in only on
+    // success, so a failed reload leaves the served tables untouched. The
+    // fresh copy's empty cache replaces the old one with the tables.
+    TPCHData fresh;
+    if (!load_all_tables(table_path, fresh))
+        return false;
+    data = std::move(fresh);
+    return true;
+}
+
 
-    num_threads = Config().num_threads;
-    total = customer_data.size();
-    size_t chunk_size = total / num_threads;
+bool runQuery5(TPCHData& data, const std::string& r_name, const std::string& start_date,
+               const std::string& end_date, int num_threads, std::map<std::string, double>& results,
+               std::string* error)
+{
+    const std::string key = r_name + "|" + start_date + "|" + end_date;
+    if (auto cached = data.cache.results.find(key)) {
+        std::cout << "Answered from the result cache." << std::endl;
+        results = *cached;
+        return true;
+    }
 
-    threads = std::vector<std::thread>();
-    threads.reserve(num_threads);
+    bool ok;
+    if (g_config.stream_lineitem)
+        ok = executeQuery5Streaming(r_name, start_date, end_date, num_threads,
+                                    data.table_path + "\\lineitem.tbl", data.customer, data.orders,
+                                    data.supplier, data.nation, data.region, results, &data.cache, error);
+    else if (data.lineitem_packed)
+        ok = executeQuery5(r_name, start_date, end_date, num_threads, data.customer, data.orders,
+                           data.packed_lineitem, data.supplier, data.nation, data.region, results,
+                           &data.cache, error);
+    else
+        ok = executeQuery5(r_name, start_date, end_date, num_threads, data.customer, data.orders,
+                           data.lineitem, data.supplier, data.nation, data.region, results, &data.cache,
+                           error);
+
+    if (ok)
+        data.cache.results.get(key, [&]() { return std::make_shared<std::map<std::string, double>>(results); });
+    return ok;
+}
 
-    std::vector<std::unordered_map<int, int>> local_cust_maps(num_threads);
 
-    // Optional but helpful
-    for (auto& m : local_cust_maps)
-        m.reserve(chunk_size / 2);
+// BATCH MODE
+//
+// Every order belongs to one customer nation, so which of a batch's queries
+// it qualifies for is a bitmask: queries whose region holds the nation and
+// whose date range holds the order date. The orders join table stores that
+// mask with the nation in the top byte, and one lineitem scan adds each
+// matching row to the [query][nation] accumulator of every bit.
 
-    for (int t = 0; t < num_threads; ++t) {
-        size_t start = t * chunk_size;
-        size_t end = (t == num_threads - 1)
-                    ? total
-                    : start + chunk_size;
+namespace {
 
-        threads.emplace_back(
-            customer_worker,
-            start,
-            end,
-            std::cref(customer_data),
-            std::ref(local_cust_maps[t])
-        );
-    }
+constexpr int kBatchNationShift = 56;
+constexpr uint64_t kBatchQueryBits = (uint64_t(1) << kBatchNationShift) - 1;
 
-    for (auto& th : threads)
-        th.join();
+// A query of the batch with its parameters resolved
+struct BatchQuery {
+    NationSet nations = 0;
+    int start_day = 0;
+    int end_day = 0;
+};
 
-    // Merge
-    std::unordered_map<int, int> cust_to_nation;
-    for (const auto& local_map : local_cust_maps) {
-        for (const auto& kv : local_map) {
-            cust_to_nation.emplace(kv);
+// Runs fn(cols, begin, end, worker) over every lineitem row, wherever the
+// loaded data keeps them: raw columns, compressed blocks decoded per
+// worker, or morsels of lineitem.tbl parsed per worker (--stream on)
+template <typename Fn>
+bool scan_lineitem(const TPCHData& data, ThreadPool& pool, Fn&& fn)
+{
+    if (g_config.stream_lineitem) {
+        const std::string path = data.table_path + "\\lineitem.tbl";
+        MappedFile mapped;
+        if (!mapped.open(path)) {
+            std::cerr << "Failed to open file: " << path << std::endl;
+            return false;
+        }
+        std::vector<LineItemSOA> batches(pool.size());
+        try {
+            parallel_for(pool, mapped.size(), kFileMorsel, [&](size_t start, size_t end, int worker) {
+                LineItemSOA& batch = batches[worker];
+                size_t rows = countChunkRows(mapped.data(), start, end);
+                batch.resize(rows);
+                readChunkMapped(mapped.data(), mapped.size(), start, end, &batch, 0);
+                LineItemColumns cols{batch.l_orderkey.data(), batch.l_suppkey.data(),
+                                     batch.l_extendedprice.data(), batch.l_discount.data()};
+                fn(cols, size_t(0), rows, worker);
+                mapped.release(start, end);
+            });
+        } catch (const std::exception& e) {
+            std::cerr << "Error streaming lineitem: " << e.what() << std::endl;
+            return false;
         }
+        return true;
     }
 
-    //  Multithreaded orderkey → nationkey 
-    num_threads = g_config.num_threads;
-    total = orders_data.size();
-    chunk_size = total / num_threads;
-    threads = std::vector<std::thread>();
-    threads.reserve(num_threads);
-
-    std::vector<std::unordered_map<int, int>> local_order_maps(num_threads);
-
-    for (int t = 0; t < num_threads; ++t) {
-        size_t start = t * chunk_size;
-        size_t end = (t == num_threads - 1)
-                    ? total
-                    : start + chunk_size;
-
-        threads.emplace_back(
-            orders_worker,
-            start,
-            end,
-            std::cref(orders_data),
-            std::cref(cust_to_nation),
-            std::cref(start_date),
-            std::cref(end_date),
-            std::ref(local_order_maps[t])
-        );
-    }
-
-    for (auto& th : threads)
-        th.join();
-
-    // Merge
-    std::unordered_map<int,int> order_to_nation;
-    for (const auto& local_map : local_order_maps) {
-        for (const auto& kv : local_map) {
-            order_to_nation.emplace(kv);
-        }
+    if (data.lineitem_packed) {
+        const PackedLineItemSOA& lineitem = data.packed_lineitem;
+        std::vector<std::unique_ptr<PackedLineItemSOA::Block>> blocks(pool.size());
+        parallel_for(pool, lineitem.size(), kRowMorsel, [&](size_t start, size_t end, int worker) {
+            if (!blocks[worker])
+                blocks[worker] = std::make_unique<PackedLineItemSOA::Block>();
+            PackedLineItemSOA::Block& block = *blocks[worker];
+            LineItemColumns cols{block.l_orderkey, block.l_suppkey, block.l_extendedprice, block.l_discount};
+            for (size_t b = start / kPackBlock; b * kPackBlock < end; ++b) {
+                lineitem.decode_block(b, block);
+                fn(cols, size_t(0), lineitem.block_rows(b), worker);
+            }
+        });
+        return true;
     }
 
+    const LineItemSOA& lineitem = data.lineitem;
+    LineItemColumns cols{lineitem.l_orderkey.data(), lineitem.l_suppkey.data(),
+                         lineitem.l_extendedprice.data(), lineitem.l_discount.data()};
+    parallel_for(pool, lineitem.size(), kRowMorsel, [&](size_t start, size_t end, int worker) {
+        fn(cols, start, end, worker);
+    });
+    return true;
+}
+
+// orderkey → (nation << 56 | query mask) for orders that qualify for at
+// least one query of the pass
+void batch_orders_filter(
+    ThreadPool& pool,
+    const OrdersSOA& orders_data,
+    const ops::JoinTable<int8_t>& customers,
+    const BatchQuery* queries,
+    size_t num_queries,
+    ops::JoinTable<uint64_t>& orders
+){
+    // Query mask per nation and per order date
+    uint64_t nation_mask[kMaxNations] = {};
+    int lo_day = queries[0].start_day, hi_day = queries[0].end_day;
+    for (size_t q = 0; q < num_queries; ++q) {
+        for (int n = 0; n < kMaxNations; ++n)
+            if (nation_in_set(queries[q].nations, n)) nation_mask[n] |= uint64_t(1) << q;
+        lo_day = std::min(lo_day, queries[q].start_day);
+        hi_day = std::max(hi_day, queries[q].end_day);
+    }
+    std::vector<uint64_t> day_mask(static_cast<size_t>(hi_day - lo_day) + 1, 0);
+    for (size_t q = 0; q < num_queries; ++q)
+        for (int d = queries[q].start_day; d < queries[q].end_day; ++d)
+            day_mask[d - lo_day] |= uint64_t(1) << q;
+
+    const unsigned span = static_cast<unsigned>(hi_day - lo_day);
+    const int* dates = orders_data.o_orderdate.data();
+    const int* custkeys = orders_data.o_custkey.data();
+    const int* orderkeys = orders_data.o_orderkey.data();
+
+    const ZoneMap& zones = orders_data.o_orderdate_zones;
+    const bool use_zones = zones.covers(orders_data.size());
+    auto skip_morsel = [&](size_t start, size_t) {
+        return use_zones && !zones.may_overlap(start, lo_day, hi_day - 1);
+    };
+
+    const int max_orderkey = max_key(orders_data.o_orderkey);
+    const bool dense = ops::use_dense_index(g_config.join_index, max_orderkey, orders_data.size());
+
+    customers.visit([&](const auto& cust_to_nation) {
+        orders.build(pool, orders_data.size(), max_orderkey, dense,
+                     [&](size_t start, size_t end, auto&& emit) {
+            for (size_t i = start; i < end; ++i) {
+                unsigned offset = static_cast<unsigned>(dates[i] - lo_day);
+                int8_t nation = cust_to_nation.get(custkeys[i]);
+                uint64_t mask = (offset < span ? day_mask[offset] : 0)
+                              & (nation >= 0 ? nation_mask[nation] : 0);
+                emit(orderkeys[i], mask ? mask | uint64_t(nation) << kBatchNationShift
+                                        : ops::JoinTable<uint64_t>::kMissing);
+            }
+        }, skip_morsel);
+    });
+}
+
+// Adds lineitem rows [start, end) to every query they qualify for
+void batch_probe_lineitem(
+    size_t start,
+    size_t end,
+    const LineItemColumns& cols,
+    const ops::JoinTable<uint64_t>& orders,
+    const ops::JoinTable<int8_t>& suppliers,
+    NationAccumulator* accs
+){
+    ops::Selection sel;
+    uint64_t tagged[ops::kBatchRows];
+
+    orders.visit([&](const auto& order_index) {
+        suppliers.visit([&](const auto& supp_index) {
+            ops::batches(start, end, [&](size_t b, size_t e) {
+                ops::semi_join(orders.filter(), cols.orderkey, b, e, sel);
+                ops::probe(order_index, cols.orderkey, sel, tagged);
+                for (uint32_t j = 0; j < sel.count; ++j) {
+                    size_t row = sel.row(j);
+                    int nation = static_cast<int>(tagged[j] >> kBatchNationShift);
+                    if (supp_index.get(cols.suppkey[row]) != nation) continue;
+
+                    int64_t revenue = discounted_revenue(cols.extendedprice[row], cols.discount[row]);
+                    for (uint64_t mask = tagged[j] & kBatchQueryBits; mask; mask &= mask - 1)
+                        accs[__builtin_ctzll(mask)].add(nation, revenue);
+                }
+            });
+        });
+    });
+}
 
-    // Multithreaded lineitem scan 
-    num_threads = g_config.num_threads;
-    size_t total_rows = lineitem_data.size();
-    threads = std::vector<std::thread>();
-    chunk_size = total_rows / num_threads;
-    std::vector<std::unordered_map<std::string, double>> local_results(num_threads);
+} // namespace
 
 
-    for (int t = 0; t < num_threads; ++t) {
-        size_t start = t * chunk_size;
-        size_t end = (t == num_threads - 1)
-                    ? total_rows
-                    : start + chunk_size;
+bool executeQuery5Batch(const TPCHData& data, const std::vector<Q5Params>& params, int num_threads,
+                        std::vector<std::map<std::string, double>>& results)
+{
+    // Resolve every query's region and dates up front
+    std::vector<BatchQuery> queries(params.size());
+    for (size_t q = 0; q < params.size(); ++q) {
+        int regionKey = -1;
+        for (size_t i = 0; i < data.region.r_name.size(); ++i)
+            if (data.region.r_name[i] == params[q].r_name) regionKey = data.region.r_regionkey[i];
+        if (regionKey == -1) {
+            std::cerr << "Unknown region in batch: " << params[q].r_name << std::endl;
+            return false;
+        }
+        if (!tbl::parse_date(params[q].start_date, queries[q].start_day) ||
+            !tbl::parse_date(params[q].end_date, queries[q].end_day)) {
+            std::cerr << "Dates must be valid YYYY-MM-DD calendar dates" << std::endl;
+            return false;
+        }
+        if (queries[q].end_day < queries[q].start_day) queries[q].end_day = queries[q].start_day;
+        for (size_t i = 0; i < data.nation.n_nationkey.size(); ++i)
+            if (data.nation.n_regionkey[i] == regionKey && nation_in_set(~NationSet(0), data.nation.n_nationkey[i]))   // keys < kMaxNations
+                queries[q].nations |= 1u << data.nation.n_nationkey[i];
+    }
 
-        threads.emplace_back(
-            lineitem_worker,
-            start,
-            end,
-            std::cref(lineitem_data),
-            std::cref(order_to_nation),
-            std::cref(supp_to_nation),
-            std::cref(nationkey_to_name),
-            std::ref(local_results[t])
-        );
+    std::unordered_map<int, std::string> nation_names;
+    for (size_t i = 0; i < data.nation.n_nationkey.size(); ++i)
+        nation_names[data.nation.n_nationkey[i]] = data.nation.n_name[i];
+
+    // Customer and supplier nations do not depend on the query
+    ThreadPool& pool = shared_pool(num_threads);
+    const NationSet all_nations = ~NationSet(0);
+    std::shared_ptr<ops::JoinTable<int8_t>> suppliers, customers;
+    {
+        PhaseTimer phase("batch.suppliers_customers", pool);
+        suppliers = build_region_table(pool, data.supplier.s_suppkey, data.supplier.s_nationkey, all_nations);
+        customers = build_region_table(pool, data.customer.c_custkey, data.customer.c_nationkey, all_nations);
+        const size_t rows = data.supplier.size() + data.customer.size();
+        phase.rows(rows, suppliers->filter().count() + customers->filter().count());
+        phase.bytes(rows * 2 * sizeof(int));
     }
 
-    for (auto& th : threads)
-        th.join();
+    results.assign(params.size(), {});
+    const size_t max_per_pass = static_cast<size_t>(kBatchNationShift);
 
-    // Merge results 
-    for (const auto& local_map : local_results) {
-        for (const auto& [nation, revenue] : local_map) {
-            results[nation] += revenue;
+    // One lineitem scan per pass of up to 56 queries
+    for (size_t first = 0; first < queries.size(); first += max_per_pass) {
+        size_t count = std::min(max_per_pass, queries.size() - first);
+
+        ops::JoinTable<uint64_t> orders;
+        {
+            PhaseTimer phase("batch.orders", pool);
+            batch_orders_filter(pool, data.orders, *customers, &queries[first], count, orders);
+            phase.rows(data.orders.size(), orders.filter().count());
+            phase.bytes(data.orders.size() * 3 * sizeof(int));
+        }
+
+        std::vector<std::vector<NationAccumulator>> local_results(
+            pool.size(), std::vector<NationAccumulator>(count));
+        std::atomic<size_t> scanned{0};
+        {
+            PhaseTimer phase("batch.lineitem", pool);
+            bool ok = scan_lineitem(data, pool, [&](const LineItemColumns& cols, size_t start, size_t end, int worker) {
+                scanned.fetch_add(end - start, std::memory_order_relaxed);
+                batch_probe_lineitem(start, end, cols, orders, *suppliers, local_results[worker].data());
+            });
+            if (!ok) return false;
+            // rows_out counts a row once per query it is added to
+            uint64_t matched = 0;
+            for (const auto& local : local_results)
+                matched += matched_rows(local);
+            phase.rows(scanned.load(), matched);
+            phase.bytes(scanned.load() * (2 * sizeof(int) + 2 * sizeof(Cents)));
+        }
+
+        for (size_t q = 0; q < count; ++q) {
+            NationAccumulator totals;
+            for (const auto& local : local_results)
+                totals.merge(local[q]);
+            for (int n = 0; n < kMaxNations; ++n)
+                if (totals.rows[n] > 0)
+                    results[first + q][nation_names[n]] = revenue_to_double(totals.revenue[n]);
         }
     }
+    return true;
+}
 
+
+// One query per line: <r_name> <start_date> <end_date>. r_name may contain
+// spaces; blank lines and lines starting with # are skipped.
+bool readBatchFile(const std::string& path, std::vector<Q5Params>& params)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "Failed to open batch file: " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::vector<std::string> words;
+        std::string w;
+        while (ss >> w) words.push_back(w);
+        if (words.empty() || words[0][0] == '#') continue;
+        if (words.size() < 3) {
+            std::cerr << "Bad batch line (expected <r_name> <start_date> <end_date>): " << line << std::endl;
+            return false;
+        }
+        Q5Params p;
+        p.r_name = words[0];
+        for (size_t i = 1; i + 2 < words.size(); ++i)
+            p.r_name += " " + words[i];
+        p.start_date = words[words.size() - 2];
+        p.end_date = words[words.size() - 1];
+        params.push_back(p);
+    }
     return true;
 }
 
@@ -477,4 +1617,29 @@ bool outputResults(const std::string& result_path, const std::map<std::string, d
 
     out.close();
     return true;
+}
+
+
+// One row per (query, nation): r_name|start_date|end_date|n_name|revenue,
+// each query's nations sorted by revenue descending
+bool outputBatchResults(const std::string& result_path, const std::vector<Q5Params>& params,
+                        const std::vector<std::map<std::string, double>>& results)
+{
+    std::ofstream out(result_path + "\\query5_batch_result.txt");
+    if (!out.is_open()) {
+        std::cerr << "Failed to open result file at: "
+                  << result_path << std::endl;
+        return false;
+    }
+    out << std::fixed << std::setprecision(2);
+    out << "r_name|start_date|end_date|n_name|revenue\n";
+
+    for (size_t q = 0; q < params.size(); ++q) {
+        std::vector<std::pair<std::string, double>> sorted_results(results[q].begin(), results[q].end());
+        std::sort(sorted_results.begin(), sorted_results.end(), comparator);
+        for (const auto& it : sorted_results)
+            out << params[q].r_name << "|" << params[q].start_date << "|" << params[q].end_date << "|"
+                << it.first << "|" << it.second << "\n";
+    }
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "server.hpp"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <streambuf>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Buffered std::streambuf over a connected socket, so a session reads and
+// writes the socket with the same getline / << code as stdin mode
+class FdStreamBuf : public std::streambuf {
+public:
+    explicit FdStreamBuf(int fd) : fd_(fd) {
+        setg(in_, in_, in_);
+        setp(out_, out_ + sizeof(out_));
+    }
+
+    ~FdStreamBuf() override { sync(); }
+
+protected:
+    int_type underflow() override {
+        ssize_t n;
+        do {
+            n = ::read(fd_, in_, sizeof(in_));
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) return traits_type::eof();
+        setg(in_, in_, in_ + n);
+        return traits_type::to_int_type(in_[0]);
+    }
+
+    int_type overflow(int_type c) override {
+        if (sync() != 0) return traits_type::eof();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        const char* p = pbase();
+        while (p < pptr()) {
+            ssize_t n = ::write(fd_, p, pptr() - p);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return -1;
+            p += n;
+        }
+        setp(out_, out_ + sizeof(out_));
+        return 0;
+    }
+
+private:
+    int fd_;
+    char in_[4096];
+    char out_[4096];
+};
+
+std::vector<std::string> split_words(const std::string& line) {
+    std::istringstream ss(line);
+    std::vector<std::string> words;
+    std::string w;
+    while (ss >> w) words.push_back(w);
+    return words;
+}
+
+// Serves request lines until the client ends the session or disconnects
+bool serve_session(std::istream& in, std::ostream& out, TPCHData& data) {
+    bool shutdown = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        bool more = handle_request(line, data, out, shutdown);
+        out.flush();
+        if (!more) break;
+    }
+    return shutdown;
+}
+
+bool serve_socket(const std::string& path, TPCHData& data) {
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        ::close(listener);
+        return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(path.c_str());
+
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listener, 16) != 0) {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(listener);
+        return false;
+    }
+    std::cout << "Serving Q5 on " << path << std::endl;
+
+    // Clients are served one at a time: each query already uses every thread
+    bool shutdown = false;
+    while (!shutdown) {
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "accept() failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        {
+            FdStreamBuf buf(client);
+            std::istream in(&buf);
+            std::ostream out(&buf);
+            shutdown = serve_session(in, out, data);
+        }
+        ::close(client);
+    }
+
+    ::close(listener);
+    ::unlink(path.c_str());
+    return shutdown;   // false if accept() failed
+}
+
+} // namespace
+
+
+bool handle_request(const std::string& line, TPCHData& data, std::ostream& reply, bool& shutdown)
+{
+    std::vector<std::string> words = split_words(line);
+    if (words.empty()) return true;
+
+    std::string command = words[0];
+    std::transform(command.begin(), command.end(), command.begin(), ::toupper);
+
+    if (command == "PING") {
+        reply << "PONG\n";
+    } else if (command == "QUIT") {
+        return false;
+    } else if (command == "SHUTDOWN") {
+        shutdown = true;
+        return false;
+    } else if (command == "RELOAD") {
+        auto t0 = std::chrono::steady_clock::now();
+        if (!loadTPCHData(data.table_path, data)) {
+            reply << "ERR reload failed, still serving the tables loaded before\n";
+        } else {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            reply << "OK 0 " << std::fixed << std::setprecision(3) << ms << "\n";
+        }
+    } else if (command == "Q5") {
+        // The dates are the last two words; the region name is everything before
+        if (words.size() < 4) {
+            reply << "ERR usage: Q5 <r_name> <start_date> <end_date>\n";
+            return true;
+        }
+        std::string r_name = words[1];
+        for (size_t i = 2; i + 2 < words.size(); ++i)
+            r_name += " " + words[i];
+        const std::string& start_date = words[words.size() - 2];
+        const std::string& end_date = words[words.size() - 1];
+
+        std::map<std::string, double> results;
+        std::string error;
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = runQuery5(data, r_name, start_date, end_date, g_config.num_threads, results, &error);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (!ok) {
+            reply << "ERR " << (error.empty() ? "query failed" : error) << "\n";
+            return true;
+        }
+
+        std::vector<std::pair<std::string, double>> sorted(results.begin(), results.end());
+        std::sort(sorted.begin(), sorted.end(), comparator);
+
+        reply << "OK " << sorted.size() << " " << std::fixed << std::setprecision(3) << ms << "\n";
+        reply << std::setprecision(2);
+        for (const auto& [name, revenue] : sorted)
+            reply << name << "|" << revenue << "\n";
+    } else {
+        reply << "ERR unknown command " << words[0] << "\n";
+    }
+    return true;
+}
+
+
+bool run_server(const std::string& endpoint, TPCHData& data, std::ostream& stdin_replies)
+{
+    // A client that disconnects mid-reply must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (endpoint == "stdin") {
+        serve_session(std::cin, stdin_replies, data);
+        return true;
+    }
+    return serve_socket(endpoint, data);
+}
@@ -0,0 +1,158 @@
+#include "thread_pool.hpp"
+#include <chrono>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+int current_tid() {
+    return static_cast<int>(::syscall(SYS_gettid));
+}
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(int num_threads) {
+    if (num_threads < 1) num_threads = 1;
+
+    for (int w = 0; w < num_threads; ++w)
+        queues_.push_back(std::make_unique<WorkerQueue>());
+
+    queues_[0]->tid = current_tid();
+    threads_.reserve(num_threads - 1);
+    for (int w = 1; w < num_threads; ++w)
+        threads_.emplace_back(&ThreadPool::worker_loop, this, w);
+
+    // Thread ids are published before the pool is handed out
+    for (int w = 1; w < num_threads; ++w)
+        while (queues_[w]->tid.load() == 0)
+            std::this_thread::yield();
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& th : threads_)
+        th.join();
+}
+
+void ThreadPool::run(size_t num_tasks, const Task& fn) {
+    dispatch(num_tasks, fn, true);
+}
+
+void ThreadPool::run_pinned(size_t num_tasks, const Task& fn) {
+    dispatch(num_tasks, fn, false);
+}
+
+void ThreadPool::dispatch(size_t num_tasks, const Task& fn, bool allow_steal) {
+    if (num_tasks == 0) return;
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+
+    // Contiguous blocks keep neighbouring morsels on one worker until
+    // stealing kicks in
+    const size_t workers = queues_.size();
+    for (size_t w = 0; w < workers; ++w) {
+        size_t begin = num_tasks * w / workers;
+        size_t end = num_tasks * (w + 1) / workers;
+        std::lock_guard<std::mutex> lock(queues_[w]->m);
+        for (size_t t = begin; t < end; ++t)
+            queues_[w]->tasks.push_back(t);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        job_ = &fn;
+        allow_steal_ = allow_steal;
+        active_ = static_cast<int>(threads_.size());
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    queues_[0]->tid.store(current_tid(), std::memory_order_relaxed);
+    drain(0);
+
+    {
+        std::unique_lock<std::mutex> lock(m_);
+        done_.wait(lock, [this] { return active_ == 0; });
+        job_ = nullptr;
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        std::swap(error, error_);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void ThreadPool::worker_loop(int worker) {
+    queues_[worker]->tid = current_tid();
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock(m_);
+        if (--active_ == 0)
+            done_.notify_one();
+    }
+}
+
+void ThreadPool::drain(int worker) {
+    size_t task;
+    uint64_t start = now_ns();
+    while (pop_own(worker, task) || (allow_steal_ && steal(worker, task))) {
+        try {
+            (*job_)(task, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_)
+                error_ = std::current_exception();
+        }
+    }
+    queues_[worker]->busy_ns.fetch_add(now_ns() - start, std::memory_order_relaxed);
+}
+
+bool ThreadPool::pop_own(int worker, size_t& task) {
+    WorkerQueue& q = *queues_[worker];
+    std::lock_guard<std::mutex> lock(q.m);
+    if (q.tasks.empty()) return false;
+    task = q.tasks.front();
+    q.tasks.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal(int worker, size_t& task) {
+    const int workers = size();
+    for (int i = 1; i < workers; ++i) {
+        WorkerQueue& q = *queues_[(worker + i) % workers];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (q.tasks.empty()) continue;
+        task = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
+
+ThreadPool& shared_pool(int num_threads) {
+    static std::unique_ptr<ThreadPool> pool;
+    if (num_threads < 1) num_threads = 1;
+    if (!pool || pool->size() != num_threads)
+        pool = std::make_unique<ThreadPool>(num_threads);
+    return *pool;
+}
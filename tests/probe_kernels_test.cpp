@@ -0,0 +1,53 @@
+// Checks that the SIMD probe kernel gives the scalar path's revenue, including
+// prices of 2^32 cents and up and discounts outside 0-100. Exits non-zero on
+// a mismatch; passes trivially where no kernel is available.
+#include "probe_kernels.hpp"
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main() {
+    const ProbeKernel kernel = select_probe_kernel();
+    if (!kernel) {
+        std::cout << "no SIMD probe kernel on this CPU, skipped" << std::endl;
+        return 0;
+    }
+
+    constexpr size_t kRows = 1003;   // not a multiple of 8, so the tail runs too
+    constexpr size_t kSlots = 64;
+    std::mt19937_64 rng(1);
+
+    std::vector<int8_t> order_nation(kSlots * 2, -1), supp_nation(kSlots * 2, -1);
+    for (size_t k = 0; k < kSlots; ++k)
+        order_nation[k] = supp_nation[k] = static_cast<int8_t>(k % 5);
+
+    std::vector<int> orderkey(kRows), suppkey(kRows);
+    std::vector<Cents> price(kRows), discount(kRows);
+    for (size_t i = 0; i < kRows; ++i) {
+        orderkey[i] = static_cast<int>(rng() % (kSlots + 8));   // some out of range
+        suppkey[i] = static_cast<int>(rng() % kSlots);
+        price[i] = static_cast<Cents>(rng() % (uint64_t(1) << 40)) - (Cents(1) << 38);
+        discount[i] = static_cast<Cents>(rng() % 300) - 100;
+    }
+
+    LineItemColumns cols{orderkey.data(), suppkey.data(), price.data(), discount.data()};
+    DenseProbeTables tables{order_nation.data(), kSlots, supp_nation.data(), kSlots, 0x1f};
+    NationAccumulator simd, scalar;
+    kernel(cols, 0, kRows, tables, simd);
+
+    for (size_t i = 0; i < kRows; ++i) {
+        if (static_cast<size_t>(orderkey[i]) >= kSlots) continue;
+        int8_t nation = order_nation[orderkey[i]];
+        if (nation < 0 || supp_nation[suppkey[i]] != nation) continue;
+        scalar.add(nation, discounted_revenue(price[i], discount[i]));
+    }
+
+    for (int n = 0; n < kMaxNations; ++n) {
+        if (simd.revenue[n] != scalar.revenue[n] || simd.rows[n] != scalar.rows[n]) {
+            std::cerr << "FAILED: nation " << n << " revenue " << simd.revenue[n]
+                      << " (SIMD) vs " << scalar.revenue[n] << " (scalar)" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+// Checks of the .tbl field parsers. Exits non-zero on the first failure.
+#include "tbl_parser.hpp"
+#include <iostream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+bool accepts(const std::string& date) {
+    int days = 0;
+    return tbl::parse_date(date, days);
+}
+
+} // namespace
+
+int main() {
+    int days = 0;
+    expect(tbl::parse_date("1970-01-01", days) && days == 0, "1970-01-01 is day 0");
+    expect(tbl::parse_date("1994-01-01", days) && days == 8766, "1994-01-01 is day 8766");
+
+    expect(accepts("1996-02-29"), "leap day in a leap year");
+    expect(accepts("2000-02-29"), "leap day in a 400-year leap year");
+    expect(accepts("1994-12-31"), "last day of the year");
+
+    expect(!accepts("1994-13-01"), "month 13");
+    expect(!accepts("1994-00-10"), "month 0");
+    expect(!accepts("1994-13-45"), "month 13, day 45");
+    expect(!accepts("1994-01-32"), "January 32");
+    expect(!accepts("1994-04-31"), "April 31");
+    expect(!accepts("1994-06-00"), "day 0");
+    expect(!accepts("1995-02-29"), "leap day in a common year");
+    expect(!accepts("1900-02-29"), "leap day in a century common year");
+
+    expect(!accepts("1994-1-01"), "short month");
+    expect(!accepts("1994/01/01"), "wrong separators");
+
+    return failures == 0 ? 0 : 1;
+}